@@ -0,0 +1,213 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// Kinds of event in a trace, stored in the low 4 bits of the first byte of each event
+enum TraceEvent {
+	EVENT_END_TICK,
+	EVENT_OBSTACLES, // Followed by the number of obstacles and their tiles, each relative to the tile before
+	EVENT_MOVE,
+	EVENT_TURN, // EVENT_TURN + the direction turned to
+	EVENT_TAKE_SHELF_ITEM = EVENT_TURN + 4,
+	EVENT_PASS_ITEM, // Followed by the item passed
+	EVENT_TAKE_ROBOT_ITEMS,
+	EVENT_SUBMIT_ITEMS,
+	EVENT_CHARGE,
+	EVENT_SIGHT, // Followed by the number of tiles discovered and each tile relative to the robot's tile
+	NUMBER_OF_TRACE_EVENTS
+};
+
+// Start of every trace, and the version of its layout
+constexpr uint32_t TRACE_MAGIC = 0x43525457; // "WTRC"
+constexpr uint8_t TRACE_VERSION = 1;
+
+// Compact record of what every robot did in a simulation, so the simulation can be replayed without deciding the robots' actions again
+// The robot of each event is stored relative to the robot of the event before it in the tick, in the high 4 bits of its first byte when close enough,
+// so most events take a single byte. Numbers are stored in as few bytes as they need, 7 bits to a byte.
+class EventTrace {
+public:
+	// Starts recording from a state written by the simulation, dropping anything recorded before
+	void start(const std::vector<uint8_t>& initialState) {
+		bytes.clear();
+		for (int i = 0; i < 4; i++) bytes.push_back((uint8_t)(TRACE_MAGIC >> (8 * i)));
+		bytes.push_back(TRACE_VERSION);
+		writeNumber(initialState.size());
+		bytes.insert(bytes.end(), initialState.begin(), initialState.end());
+		previousRobot = 0;
+		recording = true;
+	}
+	bool isRecording() const {
+		return recording;
+	}
+
+	// Robot actions that succeeded; nothing is recorded unless the trace was started
+	void move(int robot) {
+		robotEvent(EVENT_MOVE, robot);
+	}
+	void turn(int robot, int direction) {
+		robotEvent(EVENT_TURN + direction, robot);
+	}
+	void takeShelfItem(int robot) {
+		robotEvent(EVENT_TAKE_SHELF_ITEM, robot);
+	}
+	void passItem(int robot, int item) {
+		if (!recording) return;
+		robotEvent(EVENT_PASS_ITEM, robot);
+		writeNumber((uint64_t)item);
+	}
+	void takeRobotItems(int robot) {
+		robotEvent(EVENT_TAKE_ROBOT_ITEMS, robot);
+	}
+	void submitItems(int robot) {
+		robotEvent(EVENT_SUBMIT_ITEMS, robot);
+	}
+	void charge(int robot) {
+		robotEvent(EVENT_CHARGE, robot);
+	}
+	// Tiles that changed in the robots' knowledge of the map when a robot looked around
+	void sight(int robot, int robotTile, const std::vector<int>& discovered) {
+		if (!recording || discovered.empty()) return;
+		robotEvent(EVENT_SIGHT, robot);
+		writeNumber(discovered.size());
+		for (int tile : discovered) writeSigned(tile - robotTile);
+	}
+	// The obstacles were cleared and placed again on these tiles
+	void obstacles(const std::vector<int>& tiles) {
+		if (!recording) return;
+		sortedTiles.assign(tiles.begin(), tiles.end());
+		std::sort(sortedTiles.begin(), sortedTiles.end());
+
+		bytes.push_back(EVENT_OBSTACLES);
+		writeNumber(sortedTiles.size());
+		int previousTile = 0;
+		for (int tile : sortedTiles) {
+			writeNumber((uint64_t)(tile - previousTile));
+			previousTile = tile;
+		}
+	}
+	void endTick() {
+		if (!recording) return;
+		bytes.push_back(EVENT_END_TICK);
+		previousRobot = 0;
+	}
+
+	const std::vector<uint8_t>& getBytes() const {
+		return bytes;
+	}
+	// Returns false if the file could not be written
+	bool save(const std::string& path) const {
+		std::ofstream file(path.c_str(), std::ios::binary);
+		file.write((const char*)bytes.data(), (std::streamsize)bytes.size());
+		return !file.fail();
+	}
+private:
+	void robotEvent(int event, int robot) {
+		if (!recording) return;
+
+		uint64_t step = zigzag(robot - previousRobot);
+		previousRobot = robot;
+		if (step < 15) bytes.push_back((uint8_t)(event | step << 4));
+		else {
+			bytes.push_back((uint8_t)(event | 15 << 4));
+			writeNumber(step);
+		}
+	}
+	void writeNumber(uint64_t value) {
+		while (value >= 0x80) {
+			bytes.push_back((uint8_t)(value | 0x80));
+			value >>= 7;
+		}
+		bytes.push_back((uint8_t)value);
+	}
+	void writeSigned(int64_t value) {
+		writeNumber(zigzag(value));
+	}
+	// Interleaves negative and positive numbers (0, -1, 1, -2...) so small numbers of either sign take one byte
+	static uint64_t zigzag(int64_t value) {
+		return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+	}
+
+	std::vector<uint8_t> bytes;
+	std::vector<int> sortedTiles;
+	int previousRobot = 0;
+	bool recording = false;
+};
+
+// Reads the events of a trace back in the order they were recorded
+// Reading past the end marks the trace as broken, and every later read gives zeros
+class TraceReader {
+public:
+	TraceReader(const std::vector<uint8_t>& trace) : bytes(trace) {}
+
+	// Checks the start of the trace and reads the state it starts from; returns false if it is not a trace of this version
+	bool readStart(std::vector<uint8_t>& initialState) {
+		position = 0;
+		if (bytes.size() < 5) return false;
+		uint32_t magic = 0;
+		for (int i = 0; i < 4; i++) magic |= (uint32_t)bytes[i] << (8 * i);
+		if (magic != TRACE_MAGIC || bytes[4] != TRACE_VERSION) return false;
+
+		position = 5;
+		uint64_t size = readNumber();
+		if (!valid || size > bytes.size() - position) return false;
+		initialState.assign(bytes.begin() + position, bytes.begin() + position + (size_t)size);
+		position += (size_t)size;
+		return true;
+	}
+
+	// Reads the next event and its robot, or -1 for events that belong to no robot; returns false at the end of the trace
+	bool readEvent(int& event, int& robot) {
+		if (!valid || position >= bytes.size()) return false;
+
+		uint8_t first = bytes[position++];
+		event = first & 15;
+		robot = -1;
+		if (event == EVENT_END_TICK) previousRobot = 0;
+		else if (event != EVENT_OBSTACLES) {
+			uint64_t step = first >> 4;
+			if (step == 15) step = readNumber();
+			robot = previousRobot + (int)unzigzag(step);
+			previousRobot = robot;
+		}
+		return valid;
+	}
+	uint64_t readNumber() {
+		uint64_t value = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (position >= bytes.size()) break;
+			uint8_t byte = bytes[position++];
+			value |= (uint64_t)(byte & 0x7F) << shift;
+			if (byte < 0x80) return value;
+		}
+		valid = false;
+		return 0;
+	}
+	int64_t readSigned() {
+		return unzigzag(readNumber());
+	}
+
+	// Whether every read so far was within the trace
+	bool isValid() const {
+		return valid;
+	}
+	size_t getPosition() const {
+		return position;
+	}
+	// Moves to the start of a tick
+	void setPosition(size_t tickStart) {
+		position = tickStart;
+		previousRobot = 0;
+	}
+private:
+	static int64_t unzigzag(uint64_t value) {
+		return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+	}
+
+	const std::vector<uint8_t>& bytes;
+	size_t position = 0;
+	int previousRobot = 0;
+	bool valid = true;
+};
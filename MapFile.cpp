@@ -0,0 +1,235 @@
+#include "MapFile.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+	uint32_t readUint32(const uint8_t* bytes) {
+		return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+	}
+	void writeUint32(uint8_t* bytes, uint32_t value) {
+		for (int i = 0; i < 4; i++) {
+			bytes[i] = (uint8_t)(value >> (8 * i));
+		}
+	}
+}
+
+uint32_t mapChecksum(const uint8_t* tiles, size_t count) {
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < count; i++) {
+		hash = (hash ^ tiles[i]) * 16777619u;
+	}
+	return hash;
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& path) {
+	close();
+
+	HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE) return false;
+	file = handle;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(handle, &fileSize)) {
+		close();
+		return false;
+	}
+	size = (size_t)fileSize.QuadPart;
+	// Empty files cannot be mapped
+	if (size == 0) return true;
+
+	mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr) {
+		close();
+		return false;
+	}
+	data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == nullptr) {
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close() {
+	if (data != nullptr) UnmapViewOfFile(data);
+	if (mapping != nullptr) CloseHandle(mapping);
+	if (file != nullptr) CloseHandle(file);
+	data = nullptr;
+	mapping = nullptr;
+	file = nullptr;
+	size = 0;
+}
+#else
+bool MappedFile::open(const std::string& path) {
+	close();
+
+	int handle = ::open(path.c_str(), O_RDONLY);
+	if (handle < 0) return false;
+
+	struct stat status;
+	if (fstat(handle, &status) != 0) {
+		::close(handle);
+		return false;
+	}
+	size = (size_t)status.st_size;
+
+	// Empty files cannot be mapped
+	if (size > 0) {
+		void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, handle, 0);
+		if (mapped == MAP_FAILED) {
+			::close(handle);
+			size = 0;
+			return false;
+		}
+		data = (const uint8_t*)mapped;
+	}
+
+	// The mapping stays valid after the file is closed
+	::close(handle);
+	return true;
+}
+
+void MappedFile::close() {
+	if (data != nullptr) munmap((void*)data, size);
+	data = nullptr;
+	size = 0;
+}
+#endif
+
+bool MapFile::open(const std::string& path) {
+	tiles = nullptr;
+	width = 0;
+	height = 0;
+	parsedTiles.clear();
+
+	if (!file.open(path)) {
+		printf("Could not open map file %s\n", path.c_str());
+		return false;
+	}
+
+	// Binary maps start with the magic number
+	binary = file.getSize() >= sizeof(MAP_MAGIC) && memcmp(file.getData(), MAP_MAGIC, sizeof(MAP_MAGIC)) == 0;
+	if (binary) return readBinary(path);
+	else return readText(path);
+}
+
+bool MapFile::readBinary(const std::string& path) {
+	const uint8_t* data = file.getData();
+	if (file.getSize() < MAP_HEADER_SIZE) {
+		printf("Map file %s is too short for its header\n", path.c_str());
+		return false;
+	}
+
+	uint32_t version = readUint32(data + 4);
+	uint32_t mapWidth = readUint32(data + 8);
+	uint32_t mapHeight = readUint32(data + 12);
+	uint32_t checksum = readUint32(data + 16);
+	if (version != MAP_VERSION) {
+		printf("Map file %s has version %u, expected %u\n", path.c_str(), version, MAP_VERSION);
+		return false;
+	}
+	if (mapWidth == 0 || mapHeight == 0 || (uint64_t)mapWidth * mapHeight != file.getSize() - MAP_HEADER_SIZE) {
+		printf("Map file %s is %ux%u tiles but holds %llu tiles\n", path.c_str(), mapWidth, mapHeight, (unsigned long long)(file.getSize() - MAP_HEADER_SIZE));
+		return false;
+	}
+	if (mapChecksum(data + MAP_HEADER_SIZE, file.getSize() - MAP_HEADER_SIZE) != checksum) {
+		printf("Map file %s is corrupted (checksum mismatch)\n", path.c_str());
+		return false;
+	}
+
+	width = (int)mapWidth;
+	height = (int)mapHeight;
+	tiles = data + MAP_HEADER_SIZE;
+	return true;
+}
+
+bool MapFile::readText(const std::string& path) {
+	const uint8_t* data = file.getData();
+	size_t size = file.getSize();
+	int rowLength = 0;
+
+	for (size_t i = 0; i < size;) {
+		uint8_t c = data[i];
+
+		// Read a tile type
+		if (c >= '0' && c <= '9') {
+			int tileType = 0;
+			while (i < size && data[i] >= '0' && data[i] <= '9') {
+				tileType = tileType * 10 + (data[i] - '0');
+				if (tileType > 255) {
+					printf("Invalid tile type in map file %s at tile %d\n", path.c_str(), (int)parsedTiles.size());
+					return false;
+				}
+				i++;
+			}
+			parsedTiles.push_back((uint8_t)tileType);
+			rowLength++;
+		}
+		// End a row at the end of a line that had tiles on it
+		else if (c == '\n') {
+			if (rowLength > 0) {
+				if (height == 0) width = rowLength;
+				else if (rowLength != width) {
+					printf("Row %d of map file %s has %d tiles, expected %d\n", height + 1, path.c_str(), rowLength, width);
+					return false;
+				}
+				height++;
+				rowLength = 0;
+			}
+			i++;
+		}
+		else if (c == ' ' || c == '\t' || c == '\r') i++;
+		else {
+			printf("Invalid character in map file %s at tile %d\n", path.c_str(), (int)parsedTiles.size());
+			return false;
+		}
+	}
+
+	// The last row may not end with a new line
+	if (rowLength > 0) {
+		if (height == 0) width = rowLength;
+		else if (rowLength != width) {
+			printf("Row %d of map file %s has %d tiles, expected %d\n", height + 1, path.c_str(), rowLength, width);
+			return false;
+		}
+		height++;
+	}
+	if (parsedTiles.empty()) {
+		printf("Map file %s has no tiles\n", path.c_str());
+		return false;
+	}
+
+	// The text is no longer needed
+	file.close();
+	tiles = parsedTiles.data();
+	return true;
+}
+
+bool writeBinaryMap(const std::string& path, int width, int height, const uint8_t* tiles) {
+	uint8_t header[MAP_HEADER_SIZE];
+	memcpy(header, MAP_MAGIC, sizeof(MAP_MAGIC));
+	writeUint32(header + 4, MAP_VERSION);
+	writeUint32(header + 8, (uint32_t)width);
+	writeUint32(header + 12, (uint32_t)height);
+	writeUint32(header + 16, mapChecksum(tiles, (size_t)width * height));
+
+	std::ofstream file(path.c_str(), std::ios::binary);
+	if (file.fail()) return false;
+
+	file.write((const char*)header, MAP_HEADER_SIZE);
+	file.write((const char*)tiles, (std::streamsize)width * height);
+	return !file.fail();
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Binary map files start with this header, followed by one byte per tile row by row
+// All numbers in the header are little-endian
+constexpr char MAP_MAGIC[4] = { 'W', 'M', 'A', 'P' };
+constexpr uint32_t MAP_VERSION = 1;
+constexpr int MAP_HEADER_SIZE = 20; // magic, version, width, height, checksum
+
+// FNV-1a hash of the tiles of a binary map
+uint32_t mapChecksum(const uint8_t* tiles, size_t count);
+
+// A whole file mapped into memory for reading
+class MappedFile {
+public:
+	MappedFile() {}
+	~MappedFile() {
+		close();
+	}
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// Returns false if the file could not be opened or mapped
+	bool open(const std::string& path);
+	void close();
+
+	const uint8_t* getData() const {
+		return data;
+	}
+	size_t getSize() const {
+		return size;
+	}
+private:
+	const uint8_t* data = nullptr;
+	size_t size = 0;
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#endif
+};
+
+// Tiles of a map file in either the text format (tab-separated tile types, one row per line) or the binary format
+// Binary maps are read straight from the mapped file without copying
+class MapFile {
+public:
+	// Returns false and prints the reason if the file could not be read
+	bool open(const std::string& path);
+
+	// Get functions
+	int getWidth() const {
+		return width;
+	}
+	int getHeight() const {
+		return height;
+	}
+	// Tile types row by row; valid until the map file is opened again or destroyed
+	const uint8_t* getTiles() const {
+		return tiles;
+	}
+	bool isBinary() const {
+		return binary;
+	}
+private:
+	bool readBinary(const std::string& path);
+	bool readText(const std::string& path);
+
+	MappedFile file;
+	std::vector<uint8_t> parsedTiles; // Tiles read from a text map
+	const uint8_t* tiles = nullptr;
+	int width = 0;
+	int height = 0;
+	bool binary = false;
+};
+
+// Write tiles to a binary map file; returns false if the file could not be written
+bool writeBinaryMap(const std::string& path, int width, int height, const uint8_t* tiles);
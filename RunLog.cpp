@@ -0,0 +1,109 @@
+#include "RunLog.h"
+#include <sstream>
+
+namespace {
+	// Text of a string as a JSON string
+	std::string jsonString(const std::string& text) {
+		std::string quoted = "\"";
+		for (char c : text) {
+			if (c == '"' || c == '\\') quoted += '\\';
+			quoted += c;
+		}
+		return quoted + "\"";
+	}
+
+	// Text of a string as a CSV field, quoted only if it has to be
+	std::string csvField(const std::string& text) {
+		if (text.find_first_of(",\"\n") == std::string::npos) return text;
+		std::string quoted = "\"";
+		for (char c : text) {
+			if (c == '"') quoted += '"';
+			quoted += c;
+		}
+		return quoted + "\"";
+	}
+}
+
+RunLog::~RunLog() {
+	close();
+}
+
+bool RunLog::open(const std::string& path) {
+	close();
+
+	csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+	// Only start a new CSV file with the names of the columns, so runs can be appended to an existing file
+	bool empty = true;
+	{
+		std::ifstream existing(path.c_str(), std::ios::binary | std::ios::ate);
+		if (existing.is_open() && existing.tellg() > 0) empty = false;
+	}
+
+	file.open(path.c_str(), std::ios::app);
+	if (!file.is_open()) return false;
+	if (csv && empty) file << "seed,iteration,map,robots,obstacles,items,completed,failed,failure_reason,ticks,items_retrieved,dead_robots,seconds,throughput\n";
+
+	opened = true;
+	closing = false;
+	writer = std::thread(&RunLog::writeLoop, this);
+	return true;
+}
+
+void RunLog::add(const SimSettings& settings, int iteration, const RunResult& run) {
+	if (!isOpen()) return;
+
+	std::ostringstream record;
+	if (csv) {
+		record << run.seed << "," << iteration << "," << csvField(settings.mapPath) << "," << settings.numberRobots << "," << settings.numberObstacles << "," << settings.numberItems << ",";
+		record << (run.completed ? 1 : 0) << "," << (run.failed ? 1 : 0) << "," << csvField(run.failureReason) << ",";
+		record << run.ticks << "," << run.itemsRetrieved << "," << run.numDeadRobots << "," << run.seconds << ",";
+		// The throughput series is one field of space-separated numbers
+		for (int i = 0; i < (int)run.throughput.size(); i++) record << (i > 0 ? " " : "") << run.throughput[i];
+	}
+	else {
+		record << "{\"seed\":" << run.seed << ",\"iteration\":" << iteration << ",\"map\":" << jsonString(settings.mapPath);
+		record << ",\"robots\":" << settings.numberRobots << ",\"obstacles\":" << settings.numberObstacles << ",\"items\":" << settings.numberItems;
+		record << ",\"completed\":" << (run.completed ? "true" : "false") << ",\"failed\":" << (run.failed ? "true" : "false") << ",\"failure_reason\":" << jsonString(run.failureReason);
+		record << ",\"ticks\":" << run.ticks << ",\"items_retrieved\":" << run.itemsRetrieved << ",\"dead_robots\":" << run.numDeadRobots << ",\"seconds\":" << run.seconds;
+		record << ",\"throughput\":[";
+		for (int i = 0; i < (int)run.throughput.size(); i++) record << (i > 0 ? "," : "") << run.throughput[i];
+		record << "]}";
+	}
+	record << "\n";
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		records.push_back(record.str());
+	}
+	queued.notify_one();
+}
+
+void RunLog::close() {
+	if (!writer.joinable()) return;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		closing = true;
+	}
+	queued.notify_one();
+	writer.join();
+	file.close();
+	opened = false;
+}
+
+void RunLog::writeLoop() {
+	std::deque<std::string> writing;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			queued.wait(lock, [&]() { return closing || !records.empty(); });
+			if (records.empty()) return;
+			writing.swap(records);
+		}
+
+		// Write outside the lock, so adding records never waits for the file
+		for (const std::string& record : writing) file << record;
+		file.flush();
+		writing.clear();
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "Sweep.h"
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Appends one record per finished run to a CSV or JSON Lines file, every field of the run rather than averages
+// Records are written by a background thread, so adding one never waits for the file
+class RunLog {
+public:
+	RunLog() = default;
+	~RunLog();
+	RunLog(const RunLog&) = delete;
+	RunLog& operator=(const RunLog&) = delete;
+
+	// Opens a file to append to; files ending in .csv get CSV records and any other file gets JSON Lines
+	// Returns false if the file could not be opened
+	bool open(const std::string& path);
+	bool isOpen() const {
+		return opened;
+	}
+	// Queues the record of a run; can be called from any thread
+	void add(const SimSettings& settings, int iteration, const RunResult& run);
+	// Writes every queued record and closes the file
+	void close();
+private:
+	void writeLoop();
+
+	std::ofstream file;
+	bool csv = false;
+	bool opened = false;
+	std::thread writer;
+	std::mutex mutex;
+	std::condition_variable queued;
+	std::deque<std::string> records; // Formatted records waiting to be written
+	bool closing = false;
+};
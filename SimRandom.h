@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+
+// Advances a splitmix64 state and returns its next output
+inline uint64_t splitmix64(uint64_t& x) {
+	uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return z ^ (z >> 31);
+}
+
+// Mixes several values into one seed, so that related runs get unrelated streams
+inline uint64_t mixSeed(uint64_t seed, uint64_t value) {
+	uint64_t x = seed ^ (value * 0xD1342543DE82EF95ull);
+	return splitmix64(x);
+}
+
+// xoshiro256** random number generator. The same seed always gives the same sequence on every platform.
+class SimRandom {
+public:
+	SimRandom(uint64_t seed = 0) {
+		setSeed(seed);
+	}
+	void setSeed(uint64_t seed) {
+		// Expand the seed with splitmix64, which never gives an all-zero state
+		for (int i = 0; i < 4; i++) state[i] = splitmix64(seed);
+	}
+
+	uint64_t next() {
+		uint64_t result = rotl(state[1] * 5, 7) * 9;
+		uint64_t t = state[1] << 17;
+
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+
+		state[2] ^= t;
+		state[3] = rotl(state[3], 45);
+
+		return result;
+	}
+	// Random integer from 0 to n - 1
+	int nextInt(int n) {
+		return (int)(((next() >> 32) * (uint64_t)n) >> 32);
+	}
+	// Position in the sequence, for saving and restoring a generator exactly
+	void getState(uint64_t savedState[4]) const {
+		for (int i = 0; i < 4; i++) savedState[i] = state[i];
+	}
+	void setState(const uint64_t savedState[4]) {
+		for (int i = 0; i < 4; i++) state[i] = savedState[i];
+	}
+private:
+	static uint64_t rotl(uint64_t x, int k) {
+		return (x << k) | (x >> (64 - k));
+	}
+
+	uint64_t state[4];
+};
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Appends values to a binary snapshot, in the byte order of the computer writing it
+class SnapshotWriter {
+public:
+	template <typename T>
+	void write(const T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be written directly");
+		append(&value, sizeof(T));
+	}
+	void write(const std::string& text) {
+		write((uint64_t)text.size());
+		append(text.data(), text.size());
+	}
+	template <typename T>
+	void write(const std::vector<T>& values) {
+		write((uint64_t)values.size());
+		if constexpr (std::is_trivially_copyable<T>::value) append(values.data(), values.size() * sizeof(T));
+		else {
+			for (const T& value : values) write(value);
+		}
+	}
+	template <typename T>
+	void write(const std::set<T>& values) {
+		write((uint64_t)values.size());
+		for (const T& value : values) write(value);
+	}
+
+	const std::vector<uint8_t>& getBytes() const {
+		return bytes;
+	}
+private:
+	void append(const void* data, size_t size) {
+		const uint8_t* start = (const uint8_t*)data;
+		bytes.insert(bytes.end(), start, start + size);
+	}
+
+	std::vector<uint8_t> bytes;
+};
+
+// Reads values back from a binary snapshot in the order they were written
+// Reading past the end or a length longer than the rest of the snapshot marks the snapshot as broken, and every later read gives zeros
+class SnapshotReader {
+public:
+	SnapshotReader(const std::vector<uint8_t>& snapshot) : bytes(snapshot) {}
+
+	template <typename T>
+	void read(T& value) {
+		static_assert(std::is_trivially_copyable<T>::value, "Only plain values can be read directly");
+		take(&value, sizeof(T));
+	}
+	void read(std::string& text) {
+		uint64_t size = readSize(1);
+		text.assign(size, '\0');
+		if (size > 0) take(&text[0], size);
+	}
+	template <typename T>
+	void read(std::vector<T>& values) {
+		uint64_t size = readSize(std::is_trivially_copyable<T>::value ? sizeof(T) : 1);
+		values.assign(size, T());
+		if constexpr (std::is_trivially_copyable<T>::value) {
+			if (size > 0) take(values.data(), size * sizeof(T));
+		}
+		else {
+			for (T& value : values) read(value);
+		}
+	}
+	template <typename T>
+	void read(std::set<T>& values) {
+		uint64_t size = readSize(1);
+		values.clear();
+		for (uint64_t i = 0; i < size; i++) {
+			T value;
+			read(value);
+			values.insert(values.end(), value);
+		}
+	}
+
+	// Whether every read so far was within the snapshot
+	bool isValid() const {
+		return valid;
+	}
+	bool isAtEnd() const {
+		return position == bytes.size();
+	}
+	// Mark the snapshot as broken, for values that were read but make no sense
+	void fail() {
+		valid = false;
+	}
+private:
+	void take(void* data, size_t size) {
+		if (!valid || size > bytes.size() - position) {
+			valid = false;
+			memset(data, 0, size);
+			return;
+		}
+		memcpy(data, bytes.data() + position, size);
+		position += size;
+	}
+	// Number of values that follow, each at least minimumSize bytes long
+	uint64_t readSize(size_t minimumSize) {
+		uint64_t size = 0;
+		read(size);
+		if (size > (bytes.size() - position) / minimumSize) {
+			valid = false;
+			return 0;
+		}
+		return size;
+	}
+
+	const std::vector<uint8_t>& bytes;
+	size_t position = 0;
+	bool valid = true;
+};
@@ -0,0 +1,445 @@
+#include "Sweep.h"
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+SimSettings testSettingsFor(const TestSetting& setting) {
+	SimSettings settings;
+	settings.mapNumber = setting.mapNumber;
+	settings.mapPath = mapPathOf(setting.mapNumber);
+	int width = 0;
+	int height = 0;
+	if (mapSizeOf(setting.mapNumber, width, height)) {
+		settings.mapWidth = width * WH;
+		settings.mapHeight = height * WH;
+	}
+	settings.numberRobots = setting.robots;
+	settings.numberObstacles = setting.obstacles;
+	settings.maxTicks = 5000;
+	return settings;
+}
+
+uint64_t runSeedFor(uint64_t sweepSeed, const SimSettings& settings, int iteration) {
+	uint64_t seed = mixSeed(sweepSeed, (uint64_t)settings.mapNumber);
+	seed = mixSeed(seed, (uint64_t)settings.numberRobots);
+	seed = mixSeed(seed, (uint64_t)settings.numberObstacles);
+	return mixSeed(seed, (uint64_t)iteration);
+}
+
+RunResult runHeadless(const SimSettings& settings, uint64_t seed, const std::string& tracePath) {
+	RunResult result;
+	result.seed = seed;
+	auto runtime = std::chrono::steady_clock::now();
+
+	SimSettings runSettings = settings;
+	if (!tracePath.empty()) runSettings.recordTrace = true;
+	WarehouseSim* sim = new WarehouseSim(runSettings, seed);
+	if (!sim->loadMap()) {
+		result.failed = true;
+		result.failureReason = "map error";
+	}
+	else {
+		sim->spawnRobots();
+		sim->createItemList();
+
+		// Main loop
+		while (sim->step());
+		if (!tracePath.empty() && !sim->getTrace().save(tracePath)) printf("Could not write %s\n", tracePath.c_str());
+
+		result.completed = sim->isCompleted();
+		result.failed = sim->isFailed();
+		result.ticks = sim->getTicks();
+		result.itemsRetrieved = sim->getItemsRetrieved();
+		result.numDeadRobots = sim->getNumDeadRobots();
+		result.failureReason = sim->getFailureReason();
+		result.throughput = sim->getThroughput();
+		if (settings.profile) result.profile = std::make_shared<TickProfiler>(sim->getProfiler());
+	}
+	delete sim;
+
+	result.seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - runtime).count();
+	return result;
+}
+
+std::string traceFileName(const SimSettings& settings, int iteration) {
+	return "map " + std::to_string(settings.mapNumber) + " robots " + std::to_string(settings.numberRobots) + " obstacles " + std::to_string(settings.numberObstacles) + " run " + std::to_string(iteration + 1) + ".wtrace";
+}
+
+double tCritical95(int degreesOfFreedom) {
+	static const double table[30] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131,
+		2.120, 2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+	if (degreesOfFreedom < 1) return table[0];
+	if (degreesOfFreedom <= 30) return table[degreesOfFreedom - 1];
+	return 1.96;
+}
+
+double ticksPerItemMargin(const std::vector<RunResult>& runs) {
+	std::vector<double> ticksPerItem;
+	for (const RunResult& run : runs) {
+		if (run.completed && run.itemsRetrieved > 0) ticksPerItem.push_back((double)run.ticks / (double)run.itemsRetrieved);
+	}
+	int count = (int)ticksPerItem.size();
+	if (count < 2) return -1;
+
+	double mean = 0;
+	for (double value : ticksPerItem) mean += value;
+	mean /= count;
+	double variance = 0;
+	for (double value : ticksPerItem) variance += (value - mean) * (value - mean);
+	variance /= count - 1;
+	return tCritical95(count - 1) * std::sqrt(variance / count);
+}
+
+bool isPreciseEnough(const std::vector<RunResult>& runs, double precision) {
+	double margin = ticksPerItemMargin(runs);
+	if (margin < 0) return false;
+
+	double mean = 0;
+	int count = 0;
+	for (const RunResult& run : runs) {
+		if (run.completed && run.itemsRetrieved > 0) {
+			mean += (double)run.ticks / (double)run.itemsRetrieved;
+			count++;
+		}
+	}
+	return margin <= precision * mean / count;
+}
+
+bool isMostlyFailing(const std::vector<RunResult>& runs) {
+	int count = (int)runs.size();
+	if (count == 0) return false;
+	int completedRuns = 0;
+	for (const RunResult& run : runs) {
+		if (run.completed) completedRuns++;
+	}
+
+	// Wilson score interval, which stays within 0 and 1 and works for few runs or none completed
+	double z = 1.96; // Two-sided 95% critical value of the normal distribution
+	double share = (double)completedRuns / count;
+	double centre = (share + z * z / (2 * count)) / (1 + z * z / count);
+	double margin = z * std::sqrt(share * (1 - share) / count + z * z / (4.0 * count * count)) / (1 + z * z / count);
+	return centre + margin < TEST_MIN_COMPLETION;
+}
+
+void writeResultsHeader(std::ofstream& resultsFile, uint64_t sweepSeed) {
+	resultsFile << "Seed: " << sweepSeed << "\n";
+	resultsFile << "--------------------------------------------\n";
+}
+
+void writeResults(std::ofstream& resultsFile, const SimSettings& settings, const std::vector<RunResult>& runs, const std::string& stopReason) {
+	int successfulRuns = 0;
+	int failedRuns = 0;
+	for (const RunResult& run : runs) {
+		if (run.completed) successfulRuns++;
+		if (run.failed) failedRuns++;
+	}
+
+	// Calculate average metrics of the runs that retrieved every item
+	float averageTicksTaken = (float)0;
+	float averageTicksTakenPerItem = (float)0;
+	float averageDeadRobots = (float)0;
+	float averageTimeTaken = (float)0;
+	for (const RunResult& run : runs) {
+		if (run.itemsRetrieved == settings.numberItems) {
+			averageTicksTaken += (float)run.ticks;
+			averageTicksTakenPerItem += (float)run.ticks / (float)run.itemsRetrieved;
+			averageDeadRobots += (float)run.numDeadRobots;
+			averageTimeTaken += run.seconds;
+		}
+	}
+	averageTicksTaken /= (float)successfulRuns;
+	averageTicksTakenPerItem /= (float)successfulRuns;
+	averageDeadRobots /= (float)successfulRuns;
+	averageTimeTaken /= (float)successfulRuns;
+
+	resultsFile << "(Map: " << settings.mapNumber << ", Robots: " << settings.numberRobots << ", Obstacles: " << settings.numberObstacles << ")\n";
+	resultsFile << "Successful Runs: " << successfulRuns << "\n";
+	resultsFile << "Failed Runs: " << failedRuns << "\n";
+	resultsFile << "Run Seeds:";
+	for (const RunResult& run : runs) resultsFile << " " << run.seed;
+	resultsFile << "\n";
+	resultsFile << "Average Ticks Taken: " << averageTicksTaken << "\n";
+	resultsFile << "Average Ticks Taken Per Item: " << averageTicksTakenPerItem << "\n";
+	resultsFile << "Ticks Taken Per Item 95% Confidence Interval: +/- " << std::max(ticksPerItemMargin(runs), 0.0) << "\n";
+	resultsFile << "Average Dead Robots: " << averageDeadRobots << "\n";
+	resultsFile << "Average Time Taken (seconds): " << averageTimeTaken << "\n";
+	if (!stopReason.empty()) resultsFile << "Stopped: " << stopReason << "\n";
+
+	// Tick timings of all runs together
+	TickProfiler profile;
+	for (const RunResult& run : runs) {
+		if (run.profile) profile.merge(*run.profile);
+	}
+	profile.writeReport(resultsFile);
+	resultsFile << "--------------------------------------------\n";
+}
+
+namespace {
+	// Write buffered lines through to the disk, so they survive a crash or a reboot
+	void syncFile(FILE* file) {
+		fflush(file);
+#ifdef _WIN32
+		_commit(_fileno(file));
+#else
+		fsync(fileno(file));
+#endif
+	}
+}
+
+SweepJournal::~SweepJournal() {
+	close();
+}
+
+std::string SweepJournal::keyOf(const SimSettings& settings, int iteration) {
+	return std::to_string(settings.mapNumber) + " " + std::to_string(settings.numberRobots) + " " + std::to_string(settings.numberObstacles) + " " + std::to_string(iteration);
+}
+
+bool SweepJournal::open(const std::string& path, uint64_t newSweepSeed, const std::string& newOptions) {
+	close();
+	runs.clear();
+	resumedRuns = 0;
+	sweepSeed = newSweepSeed;
+	options = newOptions;
+
+	// Read the runs of an earlier sweep
+	bool hasSeed = false;
+	bool hasOptions = false;
+	bool cutShort = false;
+	std::ifstream existing(path.c_str(), std::ios::binary);
+	std::string line;
+	while (std::getline(existing, line)) {
+		// Only the last line can be missing its newline, if the sweep stopped while writing it
+		if (existing.eof()) {
+			cutShort = true;
+			break;
+		}
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+
+		std::istringstream fields(line);
+		std::string kind;
+		fields >> kind;
+		if (kind == "seed" && !hasSeed) {
+			if (fields >> sweepSeed) hasSeed = true;
+			else sweepSeed = newSweepSeed;
+		}
+		else if (kind == "options" && hasSeed && !hasOptions) {
+			std::getline(fields >> std::ws, options);
+			hasOptions = true;
+		}
+		else if (kind == "run" && hasSeed) {
+			int map = 0, robots = 0, obstacles = 0, iteration = 0, completed = 0, failed = 0, points = 0;
+			RunResult run;
+			fields >> map >> robots >> obstacles >> iteration >> run.seed >> completed >> failed >> run.ticks >> run.itemsRetrieved >> run.numDeadRobots >> run.seconds >> points;
+			for (int i = 0; i < points && fields; i++) {
+				int items = 0;
+				fields >> items;
+				run.throughput.push_back(items);
+			}
+			if (!fields) continue;
+			std::getline(fields >> std::ws, run.failureReason);
+			run.completed = completed != 0;
+			run.failed = failed != 0;
+
+			runs[std::to_string(map) + " " + std::to_string(robots) + " " + std::to_string(obstacles) + " " + std::to_string(iteration)] = run;
+		}
+	}
+	existing.close();
+
+	// The runs of a sweep with another number of iterations or stopping rule cannot be mixed with this one's
+	if (hasSeed && (!hasOptions || options != newOptions)) {
+		if (!hasOptions) options.clear();
+		runs.clear();
+		return false;
+	}
+	resumedRuns = (int)runs.size();
+
+	file = fopen(path.c_str(), "ab");
+	if (file == nullptr) return false;
+	// End a line cut short, so the next run starts on its own line and the broken one is skipped when read again
+	if (cutShort) fputs("\n", file);
+	if (!hasSeed) fprintf(file, "seed %llu\noptions %s\n", (unsigned long long)sweepSeed, options.c_str());
+	syncFile(file);
+	return true;
+}
+
+bool SweepJournal::find(const SimSettings& settings, int iteration, RunResult& run) const {
+	auto found = runs.find(keyOf(settings, iteration));
+	// A run with another seed was not part of this sweep
+	if (found == runs.end() || found->second.seed != runSeedFor(sweepSeed, settings, iteration)) return false;
+	run = found->second;
+	return true;
+}
+
+void SweepJournal::record(const SimSettings& settings, int iteration, const RunResult& run) {
+	if (file == nullptr) return;
+
+	std::ostringstream line;
+	line << "run " << keyOf(settings, iteration) << " " << run.seed << " " << (run.completed ? 1 : 0) << " " << (run.failed ? 1 : 0) << " " << run.ticks << " " << run.itemsRetrieved << " " << run.numDeadRobots << " " << run.seconds;
+	line << " " << run.throughput.size();
+	for (int items : run.throughput) line << " " << items;
+	line << " " << run.failureReason << "\n";
+
+	std::lock_guard<std::mutex> lock(mutex);
+	fputs(line.str().c_str(), file);
+	syncFile(file);
+}
+
+void SweepJournal::close() {
+	if (file == nullptr) return;
+	fclose(file);
+	file = nullptr;
+}
+
+namespace {
+	// Jobs waiting to be run by one thread. The owner takes jobs from the front and idle threads steal from the back.
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<SweepJob> jobs;
+	};
+
+	// Takes the next job for a thread, stealing from the other threads once its own queue is empty
+	bool takeJob(std::vector<WorkQueue>& queues, int self, SweepJob& job) {
+		{
+			std::lock_guard<std::mutex> lock(queues[self].mutex);
+			if (!queues[self].jobs.empty()) {
+				job = queues[self].jobs.front();
+				queues[self].jobs.pop_front();
+				return true;
+			}
+		}
+		for (size_t i = 1; i < queues.size(); i++) {
+			WorkQueue& victim = queues[(self + i) % queues.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.jobs.empty()) {
+				job = victim.jobs.back();
+				victim.jobs.pop_back();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Whether any thread has a job waiting to be taken
+	bool hasJobs(std::vector<WorkQueue>& queues) {
+		for (WorkQueue& queue : queues) {
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (!queue.jobs.empty()) return true;
+		}
+		return false;
+	}
+}
+
+SweepRunner::SweepRunner(int threads) {
+	numberThreads = threads;
+	if (numberThreads <= 0) numberThreads = (int)std::thread::hardware_concurrency();
+	if (numberThreads <= 0) numberThreads = 1;
+}
+
+std::string SweepRunner::getOptions(int iterations) const {
+	std::ostringstream out;
+	out << "iterations " << iterations << " max-iterations " << maxIterations << " precision " << precision;
+	return out.str();
+}
+
+void SweepRunner::run(const std::vector<SimSettings>& settings, int iterations, uint64_t sweepSeed, SettingDone onSettingDone, RunDone onRunDone) {
+	int numberSettings = (int)settings.size();
+	int lastIteration = maxIterations > iterations ? maxIterations : iterations;
+
+	std::vector<std::vector<RunResult>> results(numberSettings); // Runs of each combination of settings, by iteration
+	std::vector<int> finished(numberSettings, 0); // Number of iterations that have finished
+	std::vector<bool> done(numberSettings, false); // Whether no more iterations will be run
+	std::vector<std::string> stopReasons(numberSettings); // Why an adaptive sweep ran no more iterations
+	int nextSetting = 0;
+	int pending = 0; // Jobs queued or running; more can only be added while this is above 0
+	std::mutex mergeMutex;
+	std::condition_variable jobAdded;
+
+	std::vector<WorkQueue> queues(numberThreads);
+	int queuedJobs = 0;
+	auto queueJob = [&](const SweepJob& job, int queue) {
+		std::lock_guard<std::mutex> lock(queues[queue].mutex);
+		queues[queue].jobs.push_back(job);
+	};
+
+	// Add the next iterations of a combination of settings once all of its earlier iterations have finished, taking the runs already in the journal
+	// Adaptive sweeps add them one at a time until the ticks per item are precise enough or the runs mostly fail
+	auto advance = [&](int setting, int queue) {
+		while (!done[setting] && finished[setting] == (int)results[setting].size()) {
+			int started = (int)results[setting].size();
+			if (started >= iterations && maxIterations > 0) {
+				if (isPreciseEnough(results[setting], precision)) stopReasons[setting] = "precise enough";
+				else if (isMostlyFailing(results[setting])) stopReasons[setting] = "mostly failing";
+				else if (started >= lastIteration) stopReasons[setting] = "most iterations";
+			}
+			if (started >= lastIteration || !stopReasons[setting].empty()) {
+				done[setting] = true;
+				break;
+			}
+
+			int count = started < iterations ? iterations - started : 1;
+			for (int i = started; i < started + count; i++) {
+				results[setting].emplace_back();
+				if (journal != nullptr && journal->find(settings[setting], i, results[setting][i])) finished[setting]++;
+				else {
+					// Deal the first jobs out in turn so that every thread starts with a mix of cheap and expensive settings
+					queueJob({ setting, i, runSeedFor(sweepSeed, settings[setting], i) }, queue >= 0 ? queue : queuedJobs++ % numberThreads);
+					pending++;
+				}
+			}
+		}
+	};
+
+	// Hand over finished settings in list order, regardless of which thread finished first
+	auto handOver = [&]() {
+		while (nextSetting < numberSettings && done[nextSetting]) {
+			onSettingDone(nextSetting, results[nextSetting], stopReasons[nextSetting]);
+			std::vector<RunResult>().swap(results[nextSetting]);
+			nextSetting++;
+		}
+	};
+
+	for (int i = 0; i < numberSettings; i++) advance(i, -1);
+	// Settings finished entirely before the sweep was interrupted
+	handOver();
+
+	auto worker = [&](int self) {
+		SweepJob job;
+		while (!stopping) {
+			if (!takeJob(queues, self, job)) {
+				// Other threads' runs can still add iterations, so only stop once nothing is queued or running
+				// Jobs are only added while mergeMutex is held, so checking for them under it cannot miss the notification
+				std::unique_lock<std::mutex> lock(mergeMutex);
+				jobAdded.wait(lock, [&]() { return pending == 0 || stopping || hasJobs(queues); });
+				if (pending == 0) break;
+				continue;
+			}
+
+			std::string tracePath = traceFolder.empty() ? "" : traceFolder + "/" + traceFileName(settings[job.setting], job.iteration);
+			RunResult result = runHeadless(settings[job.setting], job.seed, tracePath);
+			if (journal != nullptr) journal->record(settings[job.setting], job.iteration, result);
+			if (onRunDone) onRunDone(job.setting, job.iteration, result);
+
+			std::lock_guard<std::mutex> lock(mergeMutex);
+			results[job.setting][job.iteration] = std::move(result);
+			finished[job.setting]++;
+			pending--;
+			advance(job.setting, self);
+			handOver();
+			jobAdded.notify_all();
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int i = 1; i < numberThreads; i++) threads.emplace_back(worker, i);
+	worker(0);
+	for (std::thread& thread : threads) thread.join();
+}
@@ -0,0 +1,154 @@
+#pragma once
+#include "WarehouseSim.h"
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Outcome of a single simulation
+struct RunResult {
+	uint64_t seed = 0;
+	bool completed = false;
+	bool failed = false;
+	int ticks = 0;
+	int itemsRetrieved = 0;
+	int numDeadRobots = 0;
+	float seconds = 0;
+	std::string failureReason; // Why the run failed or stopped early; empty if it completed
+	std::vector<int> throughput; // Items retrieved in every THROUGHPUT_TICKS ticks, if recorded
+	std::shared_ptr<const TickProfiler> profile; // Tick timings, if profiling was enabled; null otherwise, as the histograms are large
+};
+
+// Settings of a simulation run as part of "Test" or "Test All"
+SimSettings testSettingsFor(const TestSetting& setting);
+
+// Seed of one iteration of a combination of settings, derived from the seed of the whole sweep
+uint64_t runSeedFor(uint64_t sweepSeed, const SimSettings& settings, int iteration);
+
+// Runs a simulation to the end without rendering, and writes its event trace to tracePath if one is given
+RunResult runHeadless(const SimSettings& settings, uint64_t seed, const std::string& tracePath = "");
+// Name of the trace file of one iteration of a combination of settings
+std::string traceFileName(const SimSettings& settings, int iteration);
+
+// Two-sided 95% critical value of Student's t-distribution
+double tCritical95(int degreesOfFreedom);
+// Half the width of the 95% confidence interval of the mean ticks per item of the completed runs; -1 if fewer than 2 runs completed
+double ticksPerItemMargin(const std::vector<RunResult>& runs);
+// Whether the confidence interval of the ticks per item is within a fraction of the mean, so no more iterations are needed
+bool isPreciseEnough(const std::vector<RunResult>& runs, double precision);
+// Whether the upper end of the 95% confidence interval of the share of runs that completed is below TEST_MIN_COMPLETION,
+// so a combination of settings whose runs mostly fail or time out is not run up to the most iterations for a precision it would hardly ever reach
+bool isMostlyFailing(const std::vector<RunResult>& runs);
+
+// Writes the seed of a sweep at the top of its results file
+void writeResultsHeader(std::ofstream& resultsFile, uint64_t sweepSeed);
+// Writes the average results of the runs of one combination of settings, why an adaptive test stopped running it, and their tick timings if they were profiled
+void writeResults(std::ofstream& resultsFile, const SimSettings& settings, const std::vector<RunResult>& runs, const std::string& stopReason = "");
+
+// Finished runs of a sweep, appended to a file as each run finishes so an interrupted sweep can carry on where it stopped
+// Each run is one line, written and flushed to the disk in one go; a line cut short by a crash is ignored when the journal is read
+class SweepJournal {
+public:
+	SweepJournal() = default;
+	~SweepJournal();
+	SweepJournal(const SweepJournal&) = delete;
+	SweepJournal& operator=(const SweepJournal&) = delete;
+
+	// Opens a journal, reading the runs recorded in it by an earlier sweep, or starts a new journal for a sweep seed and the options from SweepRunner::getOptions()
+	// An existing journal keeps its own seed, so the remaining runs get the same seeds they would have had
+	// Returns false if the file could not be opened, or if it belongs to a sweep with other options, whose runs would not fit this one
+	bool open(const std::string& path, uint64_t newSweepSeed, const std::string& newOptions);
+	bool isOpen() const {
+		return file != nullptr;
+	}
+	// Seed of the sweep the journal belongs to
+	uint64_t getSweepSeed() const {
+		return sweepSeed;
+	}
+	// Options of the sweep the journal belongs to; empty for a journal written without them
+	const std::string& getOptions() const {
+		return options;
+	}
+	// Number of runs read from the journal when it was opened
+	int getResumedRuns() const {
+		return resumedRuns;
+	}
+
+	// Gets the recorded result of one iteration of a combination of settings; returns false if it has not been run yet
+	bool find(const SimSettings& settings, int iteration, RunResult& run) const;
+	// Records a finished run; can be called from any thread
+	void record(const SimSettings& settings, int iteration, const RunResult& run);
+	void close();
+private:
+	// Key of one iteration of a combination of settings
+	static std::string keyOf(const SimSettings& settings, int iteration);
+
+	FILE* file = nullptr;
+	uint64_t sweepSeed = 0;
+	std::string options;
+	int resumedRuns = 0;
+	std::map<std::string, RunResult> runs; // Runs read from the journal, by key
+	std::mutex mutex;
+};
+
+// A single simulation within a sweep
+struct SweepJob {
+	int setting; // Index of the combination of settings
+	int iteration;
+	uint64_t seed;
+};
+
+// Runs every iteration of a list of settings across several threads
+class SweepRunner {
+public:
+	SweepRunner(int threads);
+
+	// Called once per combination of settings, in the order of the list, after all of its iterations have finished
+	// The runs are released once it returns, so a long sweep only holds the runs of the settings still being run
+	// Adaptive sweeps give why no more iterations were run: "precise enough", "mostly failing" or "most iterations"; other sweeps give an empty reason
+	typedef std::function<void(int setting, const std::vector<RunResult>& runs, const std::string& stopReason)> SettingDone;
+	// Called as soon as each run finishes, from the thread that ran it, in any order
+	typedef std::function<void(int setting, int iteration, const RunResult& run)> RunDone;
+
+	// Runs each combination of settings a number of times; each run gets its own seed derived from the sweep seed
+	// Runs found in the journal, if there is one, are not run again, and every new run is recorded in it
+	void run(const std::vector<SimSettings>& settings, int iterations, uint64_t sweepSeed, SettingDone onSettingDone, RunDone onRunDone = nullptr);
+
+	void setJournal(SweepJournal* sweepJournal) {
+		journal = sweepJournal;
+	}
+	// Write the event trace of every run into a folder, named by traceFileName(), so any run can be replayed afterwards
+	void setTraceFolder(const std::string& folder) {
+		traceFolder = folder;
+	}
+	// Run more than the given number of iterations of a combination of settings, one at a time, until isPreciseEnough(), isMostlyFailing() or maxIterations is reached
+	// The iterations of each combination are checked in order, so the number run is the same however many threads are used
+	void setAdaptive(int setMaxIterations, double setPrecision) {
+		maxIterations = setMaxIterations;
+		precision = setPrecision;
+	}
+
+	// Stops a sweep running on another thread: no more runs are started, and run() returns once the runs in progress finish
+	// Combinations of settings that did not finish are not handed over; a runner cannot be started again after it was stopped
+	void stop() {
+		stopping = true;
+	}
+
+	int getThreads() {
+		return numberThreads;
+	}
+	// The options that decide which runs a sweep with this many iterations makes, to keep the journals of different sweeps apart
+	std::string getOptions(int iterations) const;
+private:
+	int numberThreads;
+	std::atomic<bool> stopping{ false };
+	SweepJournal* journal = nullptr;
+	std::string traceFolder;
+	int maxIterations = 0; // 0 for a fixed number of iterations
+	double precision = 0;
+};
@@ -0,0 +1,145 @@
+#include "TickProfiler.h"
+#include <chrono>
+#include <string>
+
+const char* phaseName(int phase) {
+	switch (phase) {
+	case PHASE_EVENTS: return "Events";
+	case PHASE_OBSTACLES: return "Obstacles";
+	case PHASE_DECIDE: return "Decide";
+	case PHASE_MOVE: return "Move";
+	case PHASE_SIGHT: return "Sight";
+	case PHASE_HISTORY: return "History";
+	case PHASE_CHECKS: return "Checks";
+	case PHASE_RENDER: return "Render";
+	}
+	return "";
+}
+
+const char* counterName(int counter) {
+	switch (counter) {
+	case COUNTER_TILES_SCANNED: return "Tiles Scanned";
+	case COUNTER_TILES_DISCOVERED: return "Tiles Discovered";
+	case COUNTER_COLLISION_CHECKS: return "Collision Checks";
+	case COUNTER_MOVES_BLOCKED: return "Moves Blocked";
+	}
+	return "";
+}
+
+void LatencyHistogram::clear() {
+	for (int i = 0; i < NUMBER_OF_BUCKETS; i++) counts[i] = 0;
+	count = 0;
+	total = 0;
+	max = 0;
+}
+
+int LatencyHistogram::bucketOf(uint64_t nanoseconds) {
+	// Durations below SUB_BUCKETS each get their own bucket
+	if (nanoseconds < SUB_BUCKETS) return (int)nanoseconds;
+
+	// Otherwise split each power of two into SUB_BUCKETS buckets
+	int power = 3;
+	while (power < 63 && nanoseconds >> (power + 1)) power++;
+	int sub = (int)(nanoseconds >> (power - 3)) & (SUB_BUCKETS - 1);
+	return (power - 2) * SUB_BUCKETS + sub;
+}
+
+uint64_t LatencyHistogram::bucketEnd(int bucket) {
+	if (bucket < SUB_BUCKETS) return (uint64_t)bucket;
+
+	int power = bucket / SUB_BUCKETS + 2;
+	uint64_t start = (uint64_t)(SUB_BUCKETS + bucket % SUB_BUCKETS) << (power - 3);
+	return start + ((uint64_t)1 << (power - 3)) - 1;
+}
+
+void LatencyHistogram::add(uint64_t nanoseconds) {
+	counts[bucketOf(nanoseconds)]++;
+	count++;
+	total += nanoseconds;
+	if (nanoseconds > max) max = nanoseconds;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+	for (int i = 0; i < NUMBER_OF_BUCKETS; i++) counts[i] += other.counts[i];
+	count += other.count;
+	total += other.total;
+	if (other.max > max) max = other.max;
+}
+
+uint64_t LatencyHistogram::percentile(double fraction) const {
+	if (count == 0) return 0;
+
+	// Find the bucket holding the sample with this rank
+	uint64_t rank = (uint64_t)(fraction * (double)count);
+	if (rank >= count) rank = count - 1;
+	uint64_t seen = 0;
+	for (int i = 0; i < NUMBER_OF_BUCKETS; i++) {
+		if (seen + counts[i] > rank) {
+			// Assume the samples are spread evenly across the bucket
+			uint64_t start = i > 0 ? bucketEnd(i - 1) + 1 : 0;
+			uint64_t width = bucketEnd(i) - start + 1;
+			uint64_t value = start + (uint64_t)((double)width * ((double)(rank - seen) + 0.5) / (double)counts[i]);
+			return value < max ? value : max;
+		}
+		seen += counts[i];
+	}
+	return max;
+}
+
+void TickProfiler::clear() {
+	for (int i = 0; i < NUMBER_OF_PHASES; i++) {
+		phaseTime[i] = 0;
+		phaseTimes[i].clear();
+	}
+	for (int i = 0; i < NUMBER_OF_COUNTERS; i++) counters[i] = 0;
+	tickTimes.clear();
+}
+
+uint64_t TickProfiler::now() const {
+	if (!enabled) return 0;
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void TickProfiler::endTick(uint64_t start) {
+	if (!enabled) return;
+
+	tickTimes.add(now() - start);
+	// Frame phases are recorded as they happen
+	for (int i = 0; i < NUMBER_OF_PHASES; i++) {
+		if (i == PHASE_EVENTS || i == PHASE_RENDER) continue;
+		phaseTimes[i].add(phaseTime[i]);
+		phaseTime[i] = 0;
+	}
+}
+
+void TickProfiler::merge(const TickProfiler& other) {
+	tickTimes.merge(other.tickTimes);
+	for (int i = 0; i < NUMBER_OF_PHASES; i++) phaseTimes[i].merge(other.phaseTimes[i]);
+	for (int i = 0; i < NUMBER_OF_COUNTERS; i++) counters[i] += other.counters[i];
+}
+
+double TickProfiler::getTicksPerSecond() const {
+	if (tickTimes.getTotal() == 0) return 0;
+	return (double)tickTimes.getCount() * 1e9 / (double)tickTimes.getTotal();
+}
+
+namespace {
+	void writeTimes(std::ostream& out, const std::string& name, const LatencyHistogram& times) {
+		out << name << " (us): p50 " << times.percentile(0.5) / 1e3 << ", p99 " << times.percentile(0.99) / 1e3 << ", max " << times.getMax() / 1e3 << ", mean " << times.getTotal() / 1e3 / (double)times.getCount() << "\n";
+	}
+}
+
+void TickProfiler::writeReport(std::ostream& out) const {
+	if (getTicks() == 0) return;
+
+	out << "Ticks Profiled: " << getTicks() << "\n";
+	out << "Ticks Per Second: " << getTicksPerSecond() << "\n";
+	writeTimes(out, "Tick Time", tickTimes);
+	for (int i = 0; i < NUMBER_OF_PHASES; i++) {
+		if (phaseTimes[i].getCount() == 0) continue;
+		writeTimes(out, std::string(phaseName(i)) + ((i == PHASE_EVENTS || i == PHASE_RENDER) ? " Time Per Frame" : " Time Per Tick"), phaseTimes[i]);
+	}
+	for (int i = 0; i < NUMBER_OF_COUNTERS; i++) {
+		out << counterName(i) << " Per Tick: " << (double)counters[i] / (double)getTicks() << "\n";
+	}
+}
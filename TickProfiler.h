@@ -0,0 +1,119 @@
+#pragma once
+#include <cstdint>
+#include <ostream>
+
+// Parts of a tick that are timed separately
+enum TickPhase {
+	PHASE_EVENTS,	 // Handling window events, once per frame (SDL program only)
+	PHASE_OBSTACLES, // Clearing and placing obstacles
+	PHASE_DECIDE,	 // Choosing each robot's goal and action
+	PHASE_MOVE,		 // Carrying out actions: moving, turning, taking, passing, charging and submitting
+	PHASE_SIGHT,	 // Recording seen tiles and updating the paths and shelves from them
+	PHASE_HISTORY,	 // Updating visit histories
+	PHASE_CHECKS,	 // Checking for completion and counting dead robots
+	PHASE_RENDER,	 // Drawing the screen, once per frame (SDL program only)
+	NUMBER_OF_PHASES
+};
+
+// Operations counted while profiling
+enum TickCounter {
+	COUNTER_TILES_SCANNED,	  // Tiles looked at by robots' sight
+	COUNTER_TILES_DISCOVERED, // Known tiles changed by robots' sight
+	COUNTER_COLLISION_CHECKS, // Moves checked for walls and robots
+	COUNTER_MOVES_BLOCKED,	  // Moves cancelled by a wall or robot
+	NUMBER_OF_COUNTERS
+};
+
+const char* phaseName(int phase);
+const char* counterName(int counter);
+
+// Histogram of durations in nanoseconds, in buckets an eighth of a power of two wide, from which percentiles can be read
+class LatencyHistogram {
+public:
+	void clear();
+	void add(uint64_t nanoseconds);
+	void merge(const LatencyHistogram& other);
+
+	// Duration that a fraction of the samples are at most, estimated to within the width of its bucket
+	uint64_t percentile(double fraction) const;
+	uint64_t getCount() const {
+		return count;
+	}
+	uint64_t getTotal() const {
+		return total;
+	}
+	uint64_t getMax() const {
+		return max;
+	}
+private:
+	static constexpr int SUB_BUCKETS = 8;
+	static constexpr int NUMBER_OF_BUCKETS = 62 * SUB_BUCKETS;
+
+	static int bucketOf(uint64_t nanoseconds);
+	// Largest duration that falls in a bucket
+	static uint64_t bucketEnd(int bucket);
+
+	uint64_t counts[NUMBER_OF_BUCKETS] = { 0 };
+	uint64_t count = 0;
+	uint64_t total = 0;
+	uint64_t max = 0;
+};
+
+// Times the phases of every tick and counts operations; does nothing unless enabled
+class TickProfiler {
+public:
+	void setEnabled(bool enable) {
+		enabled = enable;
+	}
+	bool isEnabled() const {
+		return enabled;
+	}
+	void clear();
+
+	// Current time in nanoseconds; 0 if not enabled, so timing costs nothing when profiling is off
+	uint64_t now() const;
+	// Add the time since start to a phase of the current tick and return the current time, to start timing the next phase
+	uint64_t lap(TickPhase phase, uint64_t start) {
+		if (!enabled) return 0;
+		uint64_t time = now();
+		phaseTime[phase] += time - start;
+		return time;
+	}
+	// Record the time since start as one sample of a phase that happens once per frame rather than once per tick
+	void recordFrame(TickPhase phase, uint64_t start) {
+		if (enabled) phaseTimes[phase].add(now() - start);
+	}
+	void count(TickCounter counter, uint64_t amount = 1) {
+		if (enabled) counters[counter] += amount;
+	}
+
+	// Record a whole tick that started at start, along with the time of each of its phases
+	void endTick(uint64_t start);
+	// Add the ticks recorded by another profiler
+	void merge(const TickProfiler& other);
+
+	// Get functions
+	const LatencyHistogram& getTickTimes() const {
+		return tickTimes;
+	}
+	const LatencyHistogram& getPhaseTimes(int phase) const {
+		return phaseTimes[phase];
+	}
+	uint64_t getCounter(int counter) const {
+		return counters[counter];
+	}
+	uint64_t getTicks() const {
+		return tickTimes.getCount();
+	}
+	// Ticks simulated per second of time spent in ticks
+	double getTicksPerSecond() const;
+
+	// Write the tick time percentiles, ticks per second and counters in the format of the results file
+	void writeReport(std::ostream& out) const;
+private:
+	bool enabled = false;
+	uint64_t phaseTime[NUMBER_OF_PHASES] = { 0 }; // Time of each phase in the current tick
+	LatencyHistogram tickTimes;
+	LatencyHistogram phaseTimes[NUMBER_OF_PHASES];
+	uint64_t counters[NUMBER_OF_COUNTERS] = { 0 };
+};
@@ -0,0 +1,209 @@
+#include "TraceReplay.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace {
+	// Ticks between keyframes, unless the keyframes of a long trace of a large map would take more than MAX_KEYFRAME_BYTES
+	constexpr int KEYFRAME_TICKS = 100;
+	constexpr uint64_t MAX_KEYFRAME_BYTES = 64 * 1024 * 1024;
+}
+
+TraceReplay::~TraceReplay() {
+	clear();
+}
+
+void TraceReplay::clear() {
+	// Delete robots
+	for (int i = 0; i < (int)robots.size(); i++) {
+		delete robots[i];
+	}
+	robots.clear();
+	tickStarts.clear();
+	keyframes.clear();
+}
+
+bool TraceReplay::load(const std::string& path) {
+	std::ifstream file(path.c_str(), std::ios::binary);
+	if (file.fail()) return false;
+	std::vector<uint8_t> trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	return open(trace);
+}
+
+bool TraceReplay::open(const std::vector<uint8_t>& trace) {
+	clear();
+	bytes = trace;
+
+	// The state the trace starts from
+	TraceReader reader(bytes);
+	std::vector<uint8_t> initialState;
+	if (!reader.readStart(initialState)) return false;
+
+	SnapshotReader in(initialState);
+	settings = SimSettings();
+	readSettings(in, settings);
+	in.read(seed);
+	in.read(firstTick);
+	tiles.loadCompact(in);
+	knownTiles.loadCompact(in);
+	in.read(obstacles);
+	orders.loadOrders(in);
+	uint64_t numberOfRobots = 0;
+	in.read(numberOfRobots);
+	std::vector<int> robotTiles;
+	for (uint64_t i = 0; i < numberOfRobots && in.isValid(); i++) {
+		int robotTile = 0;
+		int dir = 0;
+		float battery = 0;
+		int items[MAX_WEIGHT];
+		in.read(robotTile);
+		in.read(dir);
+		in.read(battery);
+		in.read(items);
+
+		robots.push_back(new Robot(tiles.getX(robotTile), tiles.getY(robotTile), robotTile, dir, battery, items));
+		// Match the sprite to the battery level
+		robots.back()->setBattery(battery);
+		robotTiles.push_back(robotTile);
+	}
+
+	// The grids must all match the size of the map, with every robot and obstacle on it
+	int numberOfTiles = settings.mapWidth / WH * (settings.mapHeight / WH);
+	if (!in.isValid() || !in.isAtEnd() || tiles.size() != numberOfTiles || knownTiles.size() != numberOfTiles) return false;
+	robotGrid.reset(numberOfTiles);
+	for (int i = 0; i < (int)robots.size(); i++) {
+		if (!tiles.contains(robotTiles[i]) || robotGrid.robotAt(robotTiles[i]) >= 0 || robots[i]->getDir() < 0 || robots[i]->getDir() > 3) return false;
+		robotGrid.place(i, robotTiles[i]);
+	}
+	for (int obstacle : obstacles) {
+		if (!tiles.contains(obstacle)) return false;
+	}
+
+	// Find where each tick starts, up to the last whole tick of a trace that was cut short
+	tickStarts.push_back(reader.getPosition());
+	int event = 0;
+	int robot = 0;
+	while (reader.readEvent(event, robot)) {
+		if (event == EVENT_END_TICK) tickStarts.push_back(reader.getPosition());
+		else if (event == EVENT_OBSTACLES || event == EVENT_SIGHT) {
+			uint64_t count = reader.readNumber();
+			for (uint64_t i = 0; i < count && reader.isValid(); i++) reader.readNumber();
+		}
+		else if (event == EVENT_PASS_ITEM) reader.readNumber();
+		else if (event >= NUMBER_OF_TRACE_EVENTS) break;
+	}
+	tick = firstTick;
+	lastTick = firstTick + (int)tickStarts.size() - 1;
+
+	// Replay the whole trace once, keeping keyframes to scrub back to
+	takeKeyframe();
+	keyframeTicks = std::max(KEYFRAME_TICKS, (int)((uint64_t)(lastTick - firstTick) * keyframes[0].state.size() / MAX_KEYFRAME_BYTES) + 1);
+	while (tick < lastTick) {
+		if (!replayTick()) return false;
+		if ((tick - firstTick) % keyframeTicks == 0) takeKeyframe();
+	}
+
+	restoreKeyframe(keyframes[0]);
+	return true;
+}
+
+void TraceReplay::seek(int target) {
+	target = std::max(firstTick, std::min(target, lastTick));
+
+	// Carry on from the current tick unless the target is behind it or a keyframe is closer
+	const Keyframe& keyframe = keyframes[(target - firstTick) / keyframeTicks];
+	if (target < tick || keyframe.tick > tick) restoreKeyframe(keyframe);
+	while (tick < target && replayTick());
+}
+
+int TraceReplay::getNumDeadRobots() {
+	int numDeadRobots = 0;
+	for (int i = 0; i < (int)robots.size(); i++) {
+		if (robots[i]->getBattery() <= 0) numDeadRobots++;
+	}
+	return numDeadRobots;
+}
+
+bool TraceReplay::replayTick() {
+	TraceReader reader(bytes);
+	reader.setPosition(tickStarts[tick - firstTick]);
+
+	int event = 0;
+	int robot = 0;
+	while (reader.readEvent(event, robot) && event != EVENT_END_TICK) {
+		// Old obstacles turn back into floor before the new ones are placed
+		if (event == EVENT_OBSTACLES) {
+			for (int obstacle : obstacles) tiles.setTileType(obstacle, 1);
+			obstacles.clear();
+
+			uint64_t count = reader.readNumber();
+			int obstacleTile = 0;
+			for (uint64_t i = 0; i < count && reader.isValid(); i++) {
+				obstacleTile += (int)reader.readNumber();
+				if (!tiles.contains(obstacleTile)) return false;
+				tiles.setTileType(obstacleTile, 9);
+				obstacles.push_back(obstacleTile);
+			}
+			continue;
+		}
+		if (robot < 0 || robot >= (int)robots.size()) return false;
+
+		// Carry out the action with the same functions the simulation used, so it has exactly the same effect
+		Robot* current = robots[robot];
+		bool success = false;
+		switch (event) {
+		case EVENT_MOVE: success = current->move(settings, tiles, robotGrid); break;
+		case EVENT_TURN:
+		case EVENT_TURN + 1:
+		case EVENT_TURN + 2:
+		case EVENT_TURN + 3: success = current->turn(event - EVENT_TURN); break;
+		case EVENT_TAKE_SHELF_ITEM: success = current->takeShelfItem(settings, tiles, orders); break;
+		case EVENT_PASS_ITEM: success = current->passItem(settings, robots.data(), robotGrid, knownTiles, (int)reader.readNumber()); break;
+		case EVENT_TAKE_ROBOT_ITEMS: success = current->takeRobotItem(settings, robots.data(), robotGrid); break;
+		case EVENT_SUBMIT_ITEMS: success = current->submitItems(knownTiles, orders); break;
+		case EVENT_CHARGE: success = current->charge(knownTiles); break;
+		case EVENT_SIGHT: {
+			uint64_t count = reader.readNumber();
+			for (uint64_t i = 0; i < count && reader.isValid(); i++) {
+				int discovered = current->getTile() + (int)reader.readSigned();
+				if (!knownTiles.contains(discovered)) return false;
+				knownTiles.record(tiles, discovered);
+			}
+			success = true;
+			break;
+		}
+		}
+		// An action that fails in the replay did not happen the way it was recorded
+		if (!success) return false;
+	}
+	if (!reader.isValid() || event != EVENT_END_TICK) return false;
+
+	tick++;
+	return true;
+}
+
+void TraceReplay::takeKeyframe() {
+	SnapshotWriter out;
+	tiles.saveCompact(out);
+	knownTiles.saveCompact(out);
+	out.write(obstacles);
+	orders.saveOrders(out);
+	for (int i = 0; i < (int)robots.size(); i++) {
+		robots[i]->save(out);
+	}
+	keyframes.push_back({ tick, out.getBytes() });
+}
+
+void TraceReplay::restoreKeyframe(const Keyframe& keyframe) {
+	SnapshotReader in(keyframe.state);
+	tiles.loadCompact(in);
+	knownTiles.loadCompact(in);
+	in.read(obstacles);
+	orders.loadOrders(in);
+	robotGrid.reset(tiles.size());
+	for (int i = 0; i < (int)robots.size(); i++) {
+		robots[i]->load(in);
+		robotGrid.place(i, robots[i]->getTile());
+	}
+	tick = keyframe.tick;
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include "EventTrace.h"
+#include "WarehouseSim.h"
+#include <string>
+#include <vector>
+
+// Plays back a recorded trace, carrying out the robots' recorded actions without deciding them again,
+// so a simulation can be watched at any speed and scrubbed back and forth after it was run
+class TraceReplay {
+public:
+	TraceReplay() = default;
+	~TraceReplay();
+	TraceReplay(const TraceReplay&) = delete;
+	TraceReplay& operator=(const TraceReplay&) = delete;
+
+	// Reads a trace and replays it once to check it and take keyframes; returns false if it is not a valid trace
+	bool load(const std::string& path);
+	bool open(const std::vector<uint8_t>& trace);
+
+	// Moves to the state at the end of a tick, between getFirstTick() and getLastTick()
+	// Going backwards carries on from the closest keyframe before the tick instead of the start of the trace
+	void seek(int tick);
+	int getTick() {
+		return tick;
+	}
+	// Tick the trace starts from; 0 unless recording started part of the way through a simulation
+	int getFirstTick() {
+		return firstTick;
+	}
+	int getLastTick() {
+		return lastTick;
+	}
+
+	const SimSettings& getSettings() {
+		return settings;
+	}
+	uint64_t getSeed() {
+		return seed;
+	}
+	const TileGrid& getTiles() {
+		return tiles;
+	}
+	const TileGrid& getKnownTiles() {
+		return knownTiles;
+	}
+	// The robot with an index; nullptr if there is none
+	Robot* getRobot(int index) {
+		if (index >= 0 && index < (int)robots.size()) return robots[index];
+		else return nullptr;
+	}
+	int getNumberOfRobots() {
+		return (int)robots.size();
+	}
+	int getItemsRetrieved() {
+		return orders.getRetrieved();
+	}
+	int getNumDeadRobots();
+private:
+	// State of the replay at the start of every keyframeTicks ticks
+	struct Keyframe {
+		int tick;
+		std::vector<uint8_t> state;
+	};
+
+	// Carries out the events of the next tick; returns false if one of them could not be carried out as recorded
+	bool replayTick();
+	void takeKeyframe();
+	void restoreKeyframe(const Keyframe& keyframe);
+	void clear();
+
+	std::vector<uint8_t> bytes;
+	std::vector<size_t> tickStarts; // Position of the first event of each tick in bytes, from the first tick after getFirstTick()
+	std::vector<Keyframe> keyframes;
+	int keyframeTicks = 0;
+
+	SimSettings settings;
+	uint64_t seed = 0;
+	int firstTick = 0;
+	int lastTick = 0;
+	int tick = 0;
+	TileGrid tiles;
+	TileGrid knownTiles;
+	std::vector<int> obstacles;
+	OrderIndex orders;
+	std::vector<Robot*> robots;
+	RobotGrid robotGrid;
+};
@@ -0,0 +1,372 @@
+#include "MapFile.h"
+#include "Sweep.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Timing of one benchmark on one map, in nanoseconds per operation
+struct BenchmarkResult {
+	std::string benchmark;
+	std::string map;
+	long long operations = 0; // Operations timed in each sample
+	double mean = 0;
+	double stddev = 0;
+	double ciLow = 0; // 95% confidence interval of the mean
+	double ciHigh = 0;
+	double median = 0;
+	double min = 0;
+};
+
+// A map with robots spawned on it, for timing the robots' functions on their own
+struct RobotFixture {
+	SimSettings settings;
+	TileGrid tiles;
+	RobotGrid robotGrid;
+	std::vector<Robot> robots;
+};
+
+// Runs one sample of a benchmark, doing its own untimed setup, and returns the nanoseconds taken per operation
+typedef std::function<double()> Sample;
+
+volatile long long sink = 0; // Keeps the compiler from removing the work being timed
+
+void printUsage() {
+	printf("Usage: \"Warehouse Robot Benchmark\" [options]\n");
+	printf("Times Robot::getTile, Robot::move, Robot::sight, loading the map and whole ticks on map1 to map8 and test_map\n");
+	printf("Options:\n");
+	printf("  --map NAME         Only time one map, such as map4 or test_map\n");
+	printf("  --robots N         Number of robots, 1 to %d (default: %d)\n", MAX_FLEET, MAX_ROBOTS);
+	printf("  --samples N        Number of timed samples of each benchmark, 2 or more (default: 20)\n");
+	printf("  --warmup N         Number of samples run before timing starts (default: 3)\n");
+	printf("  --seed N           Seed of the robots' positions and the simulations (default: 1)\n");
+	printf("  --output FILE      JSON results file (default: benchmark results.json)\n");
+	printf("  --baseline FILE    JSON results file of an earlier run to compare against\n");
+	printf("  --threshold N      Percentage a benchmark must slow down by to count as a regression (default: 5)\n");
+}
+
+// Map file of a shipped map, preferring its binary map like mapPathOf()
+std::string benchmarkMapPath(const std::string& name) {
+	std::string path = "warehouse_resources/" + name;
+	if (std::ifstream(path + ".wmap").good()) return path + ".wmap";
+	else return path + ".map";
+}
+
+// Runs the warmup samples and then the timed samples of a benchmark
+BenchmarkResult measure(const std::string& benchmark, const std::string& map, long long operations, int warmup, int samples, const Sample& sample) {
+	for (int i = 0; i < warmup; i++) sample();
+
+	std::vector<double> times;
+	for (int i = 0; i < samples; i++) times.push_back(sample());
+
+	BenchmarkResult result;
+	result.benchmark = benchmark;
+	result.map = map;
+	result.operations = operations;
+	for (double time : times) result.mean += time;
+	result.mean /= (double)samples;
+	for (double time : times) result.stddev += (time - result.mean) * (time - result.mean);
+	result.stddev = std::sqrt(result.stddev / (double)(samples - 1));
+
+	double margin = tCritical95(samples - 1) * result.stddev / std::sqrt((double)samples);
+	result.ciLow = result.mean - margin;
+	result.ciHigh = result.mean + margin;
+
+	std::sort(times.begin(), times.end());
+	result.median = samples % 2 == 1 ? times[samples / 2] : (times[samples / 2 - 1] + times[samples / 2]) / 2;
+	result.min = times[0];
+
+	printf("%-8s %-9s %12.2f ns/op  +/- %8.2f  (median %10.2f, min %10.2f)\n", map.c_str(), benchmark.c_str(), result.mean, margin, result.median, result.min);
+	fflush(stdout);
+	return result;
+}
+
+double nanosecondsSince(std::chrono::steady_clock::time_point start) {
+	return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Loads a map and spawns robots on random walkable tiles, the same way every time for a seed
+bool makeFixture(const std::string& path, int numberRobots, uint64_t seed, RobotFixture& fixture) {
+	MapFile map;
+	if (!map.open(path)) return false;
+
+	fixture.settings.mapPath = path;
+	fixture.settings.mapWidth = map.getWidth() * WH;
+	fixture.settings.mapHeight = map.getHeight() * WH;
+	fixture.tiles.reset(map.getWidth(), map.getHeight());
+	fixture.robotGrid.reset(fixture.tiles.size());
+	fixture.robots.clear();
+
+	// Number the shelves' items like WarehouseSim::loadMap()
+	TileSampler spawnTiles;
+	spawnTiles.reset(fixture.tiles.size());
+	int numberOfShelves = 0;
+	for (int i = 0; i < fixture.tiles.size(); i++) {
+		int tileType = map.getTiles()[i];
+		if (tileType >= 2 && tileType <= 5) {
+			fixture.tiles.setTile(i, tileType, numberOfShelves + 1, weightOf(numberOfShelves + 1));
+			numberOfShelves++;
+		}
+		else fixture.tiles.setTile(i, tileType);
+
+		if (tileType == 1 || (tileType >= 6 && tileType <= 8)) spawnTiles.insert(i);
+	}
+
+	SimRandom random(seed);
+	for (int i = 0; i < numberRobots && spawnTiles.size() > 0; i++) {
+		int spawnTile = spawnTiles.sample(random);
+		spawnTiles.remove(spawnTile);
+		fixture.robots.push_back(Robot(fixture.tiles.getX(spawnTile), fixture.tiles.getY(spawnTile), spawnTile));
+		fixture.robotGrid.place(i, spawnTile);
+	}
+	return true;
+}
+
+void writeJson(const std::string& path, uint64_t seed, int numberRobots, int warmup, int samples, const std::vector<BenchmarkResult>& results) {
+	std::ofstream file(path.c_str());
+	file << "{\n";
+	file << "  \"seed\": " << seed << ",\n";
+	file << "  \"robots\": " << numberRobots << ",\n";
+	file << "  \"warmup\": " << warmup << ",\n";
+	file << "  \"samples\": " << samples << ",\n";
+	file << "  \"results\": [\n";
+	for (int i = 0; i < (int)results.size(); i++) {
+		const BenchmarkResult& result = results[i];
+		file << "    { \"benchmark\": \"" << result.benchmark << "\", \"map\": \"" << result.map << "\", \"operations\": " << result.operations;
+		file << ", \"mean_ns\": " << result.mean << ", \"stddev_ns\": " << result.stddev << ", \"ci95_low_ns\": " << result.ciLow << ", \"ci95_high_ns\": " << result.ciHigh;
+		file << ", \"median_ns\": " << result.median << ", \"min_ns\": " << result.min << " }" << (i + 1 < (int)results.size() ? "," : "") << "\n";
+	}
+	file << "  ]\n";
+	file << "}\n";
+}
+
+// Value of a key in a flat JSON object; empty if the key is missing
+std::string jsonValue(const std::string& object, const std::string& key) {
+	size_t position = object.find("\"" + key + "\"");
+	if (position == std::string::npos) return "";
+	position = object.find(':', position);
+	if (position == std::string::npos) return "";
+	position = object.find_first_not_of(" \t\r\n", position + 1);
+	if (position == std::string::npos) return "";
+
+	if (object[position] == '"') {
+		size_t end = object.find('"', position + 1);
+		return object.substr(position + 1, end - position - 1);
+	}
+	size_t end = object.find_first_of(",} \t\r\n", position);
+	return object.substr(position, end - position);
+}
+
+// Reads the results written by writeJson(); returns false if the file could not be read
+bool readJson(const std::string& path, std::vector<BenchmarkResult>& results) {
+	std::ifstream file(path.c_str());
+	if (file.fail()) return false;
+	std::stringstream text;
+	text << file.rdbuf();
+	std::string json = text.str();
+
+	size_t position = json.find("\"results\"");
+	if (position == std::string::npos) return false;
+	while ((position = json.find('{', position)) != std::string::npos) {
+		size_t end = json.find('}', position);
+		if (end == std::string::npos) break;
+		std::string object = json.substr(position, end - position + 1);
+		position = end;
+
+		BenchmarkResult result;
+		result.benchmark = jsonValue(object, "benchmark");
+		result.map = jsonValue(object, "map");
+		result.mean = atof(jsonValue(object, "mean_ns").c_str());
+		result.ciLow = atof(jsonValue(object, "ci95_low_ns").c_str());
+		result.ciHigh = atof(jsonValue(object, "ci95_high_ns").c_str());
+		if (!result.benchmark.empty()) results.push_back(result);
+	}
+	return true;
+}
+
+// Compares results against a baseline; returns the number of regressions
+int compare(const std::vector<BenchmarkResult>& baseline, const std::vector<BenchmarkResult>& results, double threshold) {
+	int regressions = 0;
+	printf("\nCompared with the baseline:\n");
+	for (const BenchmarkResult& result : results) {
+		const BenchmarkResult* before = nullptr;
+		for (const BenchmarkResult& old : baseline) {
+			if (old.benchmark == result.benchmark && old.map == result.map) before = &old;
+		}
+		if (before == nullptr || before->mean <= 0) {
+			printf("%-8s %-9s not in baseline\n", result.map.c_str(), result.benchmark.c_str());
+			continue;
+		}
+
+		// Only count a change once it is larger than the threshold and the confidence intervals no longer overlap
+		double change = 100 * (result.mean - before->mean) / before->mean;
+		const char* verdict = "same";
+		if (change > threshold && result.ciLow > before->ciHigh) {
+			verdict = "REGRESSION";
+			regressions++;
+		}
+		else if (change < -threshold && result.ciHigh < before->ciLow) verdict = "faster";
+
+		printf("%-8s %-9s %12.2f -> %12.2f ns/op  %+7.1f%%  %s\n", result.map.c_str(), result.benchmark.c_str(), before->mean, result.mean, change, verdict);
+	}
+	return regressions;
+}
+
+int main(int argc, char** argv) {
+	std::string outputPath = "benchmark results.json";
+	std::string baselinePath;
+	std::string onlyMap;
+	int numberRobots = MAX_ROBOTS;
+	int samples = 20;
+	int warmup = 3;
+	double threshold = 5;
+	uint64_t seed = 1;
+
+	// Read command-line arguments
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "--map" && i + 1 < argc) onlyMap = argv[++i];
+		else if (arg == "--robots" && i + 1 < argc) numberRobots = atoi(argv[++i]);
+		else if (arg == "--samples" && i + 1 < argc) samples = atoi(argv[++i]);
+		else if (arg == "--warmup" && i + 1 < argc) warmup = atoi(argv[++i]);
+		else if (arg == "--seed" && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+		else if (arg == "--output" && i + 1 < argc) outputPath = argv[++i];
+		else if (arg == "--baseline" && i + 1 < argc) baselinePath = argv[++i];
+		else if (arg == "--threshold" && i + 1 < argc) threshold = atof(argv[++i]);
+		else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (numberRobots < 1 || numberRobots > MAX_FLEET || samples < 2 || warmup < 0 || threshold < 0) {
+		printUsage();
+		return 1;
+	}
+
+	// Read the baseline first, so a missing file is reported before spending time on the benchmarks
+	std::vector<BenchmarkResult> baseline;
+	if (!baselinePath.empty() && !readJson(baselinePath, baseline)) {
+		printf("Could not read baseline %s\n", baselinePath.c_str());
+		return 1;
+	}
+
+	std::vector<std::string> maps;
+	for (int i = 1; i <= 8; i++) maps.push_back("map" + std::to_string(i));
+	maps.push_back("test_map");
+	if (!onlyMap.empty()) maps.assign(1, onlyMap);
+
+	printf("Benchmarking %d robots with seed %llu, %d warmup and %d timed samples\n\n", numberRobots, (unsigned long long)seed, warmup, samples);
+
+	std::vector<BenchmarkResult> results;
+	for (const std::string& name : maps) {
+		std::string path = benchmarkMapPath(name);
+		RobotFixture fixture;
+		if (!makeFixture(path, numberRobots, seed, fixture)) return 1;
+		int robots = (int)fixture.robots.size();
+
+		// Robot::getTile: reading every robot's tile
+		const int tileRounds = 10000;
+		results.push_back(measure("getTile", name, (long long)tileRounds * robots, warmup, samples, [&]() {
+			auto start = std::chrono::steady_clock::now();
+			long long total = 0;
+			for (int round = 0; round < tileRounds; round++) {
+				for (Robot& robot : fixture.robots) total += robot.getTile();
+			}
+			double time = nanosecondsSince(start);
+			sink = sink + total;
+			return time / ((double)tileRounds * robots);
+		}));
+
+		// Robot::move: every robot moving, turning every 4 moves, from the same starting positions in every sample
+		const int moveRounds = 200;
+		results.push_back(measure("move", name, (long long)moveRounds * robots, warmup, samples, [&]() {
+			std::vector<Robot> movers = fixture.robots;
+			RobotGrid robotGrid = fixture.robotGrid;
+
+			auto start = std::chrono::steady_clock::now();
+			for (int round = 0; round < moveRounds; round++) {
+				for (int i = 0; i < robots; i++) {
+					movers[i].turn((round / 4 + i) % 4);
+					movers[i].move(fixture.settings, fixture.tiles, robotGrid);
+				}
+			}
+			double time = nanosecondsSince(start);
+			sink = sink + movers[0].getTile();
+			return time / ((double)moveRounds * robots);
+		}));
+
+		// Robot::sight: every robot recording what it sees, starting from a map with nothing known
+		const int sightRounds = 200;
+		results.push_back(measure("sight", name, (long long)sightRounds * robots, warmup, samples, [&]() {
+			TileGrid tileDatabase;
+			tileDatabase.reset(fixture.tiles.getWidth(), fixture.tiles.getHeight());
+			std::vector<int> changedTiles;
+
+			auto start = std::chrono::steady_clock::now();
+			long long total = 0;
+			for (int round = 0; round < sightRounds; round++) {
+				for (Robot& robot : fixture.robots) {
+					changedTiles.clear();
+					total += robot.sight(fixture.settings, fixture.tiles, tileDatabase, changedTiles);
+				}
+			}
+			double time = nanosecondsSince(start);
+			sink = sink + total;
+			return time / ((double)sightRounds * robots);
+		}));
+
+		// WarehouseSim::loadMap: reading the map file and setting up every tile
+		const int loads = 50;
+		results.push_back(measure("loadMap", name, loads, warmup, samples, [&]() {
+			auto start = std::chrono::steady_clock::now();
+			for (int i = 0; i < loads; i++) {
+				WarehouseSim sim(fixture.settings, seed);
+				sink = sink + sim.loadMap();
+			}
+			return nanosecondsSince(start) / loads;
+		}));
+
+		// WarehouseSim::step: whole ticks of every robot deciding and acting, after the robots have spread out
+		const int stepWarmupTicks = 20;
+		const int stepTicks = 50;
+		results.push_back(measure("step", name, stepTicks, warmup, samples, [&]() {
+			SimSettings settings = fixture.settings;
+			settings.numberRobots = numberRobots;
+			WarehouseSim sim(settings, seed);
+			// A sample that could not be timed would pass for a very fast one, so stop instead of averaging it in
+			if (!sim.loadMap()) exit(1);
+			sim.spawnRobots();
+			sim.createItemList();
+			for (int i = 0; i < stepWarmupTicks && sim.step(); i++);
+
+			auto start = std::chrono::steady_clock::now();
+			int ticks = 0;
+			while (ticks < stepTicks && sim.step()) ticks++;
+			double time = nanosecondsSince(start);
+			if (ticks == 0) {
+				printf("The simulation on %s finished before any ticks could be timed\n", name.c_str());
+				exit(1);
+			}
+			return time / ticks;
+		}));
+	}
+
+	writeJson(outputPath, seed, numberRobots, warmup, samples, results);
+	printf("\nResults written to %s\n", outputPath.c_str());
+
+	if (!baseline.empty()) {
+		int regressions = compare(baseline, results, threshold);
+		if (regressions > 0) {
+			printf("Benchmarks slower than the baseline: %d\n", regressions);
+			return 2;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,359 @@
+#include "RunLog.h"
+#include "Sweep.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+
+void printUsage() {
+	printf("Usage: \"Warehouse Robot Headless\" [start|test|testall|scale|fork] [options]\n");
+	printf("  start      Run a single simulation for the chosen settings (default)\n");
+	printf("  test       Run %d simulations for each of the 24 logical combinations of settings\n", TEST_ITERATIONS);
+	printf("  testall    Run %d simulations for all 1568 combinations of settings\n", TEST_ITERATIONS);
+	printf("  scale      Time the chosen map with fleets of 100 to %d robots\n", MAX_FLEET);
+	printf("  fork       Run one simulation for a number of ticks, then run several variants on from that state\n");
+	printf("Options:\n");
+	printf("  --map N          Map number, 1 to 8 (start, scale and fork)\n");
+	printf("  --map-file FILE  Map file to use instead of a numbered map, of any size (start, scale and fork)\n");
+	printf("  --robots N       Number of robots, 1 to %d (start and fork)\n", MAX_FLEET);
+	printf("  --obstacles N    Number of obstacles, 0 to %d (start, scale and fork)\n", MAX_OBSTACLES);
+	printf("  --ticks N        Number of ticks to time each fleet for (scale only, default: 200)\n");
+	printf("  --seed N         Seed of the simulation (start) or of the whole sweep (test and testall)\n");
+	printf("  --threads N      Number of simulations to run at once (default: one per CPU core)\n");
+	printf("  --two-phase      Decide all robots' actions in parallel before carrying them out (start and scale)\n");
+	printf("  --tick-threads N Number of threads deciding actions with --two-phase (default: one per CPU core)\n");
+	printf("  --output FILE    Results file for test and testall\n");
+	printf("  --profile        Time each phase of every tick and count operations, and print or save the results\n");
+	printf("  --runs FILE      Append a record of every run to a CSV (.csv) or JSON Lines file as soon as it finishes (start, test and testall)\n");
+	printf("  --throughput     Add the items retrieved in every %d ticks to the records written by --runs\n", THROUGHPUT_TICKS);
+	printf("  --journal FILE   Record every finished run of test or testall, and skip the runs already recorded when run again\n");
+	printf("  --trace FILE     Record the event trace of the simulation, to replay it in the simulation program (start only)\n");
+	printf("  --traces FOLDER  Record the event trace of every run of test or testall in a folder, one file per run\n");
+	printf("  --fork-at N      Number of ticks to run before forking (fork only, default: 500)\n");
+	printf("  --variants N     Number of variants to run from the forked state, each with its own seed (fork only, default: %d)\n", TEST_ITERATIONS);
+	printf("  --save-snapshot FILE  Save the state the variants are forked from (fork only)\n");
+	printf("  --load-snapshot FILE  Fork the variants from a saved state instead of running up to it (fork only)\n");
+	printf("  --iterations N   Number of simulations for each combination of settings in test and testall (default: %d), or the least with --adaptive (default: %d)\n", TEST_ITERATIONS, MIN_TEST_ITERATIONS);
+	printf("  --adaptive       Keep running simulations of each combination of settings until the ticks per item are precise enough\n");
+	printf("  --max-iterations N  Most simulations for each combination of settings with --adaptive (default: %d)\n", MAX_TEST_ITERATIONS);
+	printf("  --precision N    Percentage of the mean ticks per item that the 95%% confidence interval must be within with --adaptive (default: %g)\n", TEST_PRECISION * 100);
+}
+
+int main(int argc, char** argv) {
+	std::string mode = "start";
+	std::string resultsPath = "simulation test results.txt";
+	std::string mapFile;
+	TestSetting chosen = { 1, MAX_ROBOTS, MAX_OBSTACLES };
+	int threads = 0;
+	int scaleTicks = 200;
+	bool twoPhase = false;
+	int tickThreads = 0;
+	bool profile = false;
+	std::string runsPath;
+	bool throughput = false;
+	std::string journalPath;
+	std::string tracePath;
+	std::string tracesFolder;
+	int iterations = 0;
+	bool adaptive = false;
+	int maxIterations = MAX_TEST_ITERATIONS;
+	double precision = TEST_PRECISION * 100;
+	int forkAt = 500;
+	int variants = TEST_ITERATIONS;
+	std::string saveSnapshotPath;
+	std::string loadSnapshotPath;
+	bool obstaclesGiven = false;
+	// Random seed unless one is given
+	uint64_t seed = (uint64_t)time(0);
+	bool seedGiven = false;
+
+	// Read command-line arguments
+	for (int i = 1; i < argc; i++) {
+		std::string arg = argv[i];
+		if (arg == "start" || arg == "test" || arg == "testall" || arg == "scale" || arg == "fork") mode = arg;
+		else if (arg == "--map" && i + 1 < argc) chosen.mapNumber = atoi(argv[++i]);
+		else if (arg == "--map-file" && i + 1 < argc) mapFile = argv[++i];
+		else if (arg == "--robots" && i + 1 < argc) chosen.robots = atoi(argv[++i]);
+		else if (arg == "--obstacles" && i + 1 < argc) {
+			chosen.obstacles = atoi(argv[++i]);
+			obstaclesGiven = true;
+		}
+		else if (arg == "--seed" && i + 1 < argc) {
+			seed = strtoull(argv[++i], nullptr, 10);
+			seedGiven = true;
+		}
+		else if (arg == "--threads" && i + 1 < argc) threads = atoi(argv[++i]);
+		else if (arg == "--output" && i + 1 < argc) resultsPath = argv[++i];
+		else if (arg == "--ticks" && i + 1 < argc) scaleTicks = atoi(argv[++i]);
+		else if (arg == "--two-phase") twoPhase = true;
+		else if (arg == "--tick-threads" && i + 1 < argc) tickThreads = atoi(argv[++i]);
+		else if (arg == "--profile") profile = true;
+		else if (arg == "--runs" && i + 1 < argc) runsPath = argv[++i];
+		else if (arg == "--throughput") throughput = true;
+		else if (arg == "--journal" && i + 1 < argc) journalPath = argv[++i];
+		else if (arg == "--trace" && i + 1 < argc) tracePath = argv[++i];
+		else if (arg == "--traces" && i + 1 < argc) tracesFolder = argv[++i];
+		else if (arg == "--iterations" && i + 1 < argc) iterations = atoi(argv[++i]);
+		else if (arg == "--adaptive") adaptive = true;
+		else if (arg == "--max-iterations" && i + 1 < argc) maxIterations = atoi(argv[++i]);
+		else if (arg == "--precision" && i + 1 < argc) precision = atof(argv[++i]);
+		else if (arg == "--fork-at" && i + 1 < argc) forkAt = atoi(argv[++i]);
+		else if (arg == "--variants" && i + 1 < argc) variants = atoi(argv[++i]);
+		else if (arg == "--save-snapshot" && i + 1 < argc) saveSnapshotPath = argv[++i];
+		else if (arg == "--load-snapshot" && i + 1 < argc) loadSnapshotPath = argv[++i];
+		else {
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (iterations == 0) iterations = adaptive ? MIN_TEST_ITERATIONS : TEST_ITERATIONS;
+
+	if (chosen.mapNumber < 1 || chosen.mapNumber > 8 || chosen.robots < 1 || chosen.robots > MAX_FLEET || chosen.obstacles < 0 || chosen.obstacles > MAX_OBSTACLES || threads < 0 || tickThreads < 0 || scaleTicks < 1
+		|| iterations < 1 || (adaptive && maxIterations < iterations) || precision <= 0 || forkAt < 0 || variants < 1) {
+		printUsage();
+		return 1;
+	}
+
+	// Records of every run, written as the runs finish
+	RunLog runLog;
+	if (!runsPath.empty() && !runLog.open(runsPath)) {
+		printf("Could not open %s\n", runsPath.c_str());
+		return 1;
+	}
+
+	// Run simulation for the chosen settings
+	if (mode == "start") {
+		SimSettings settings = testSettingsFor(chosen);
+		settings.maxTicks = 0;
+		if (!mapFile.empty()) settings.mapPath = mapFile;
+		settings.twoPhaseTicks = twoPhase;
+		settings.tickThreads = tickThreads;
+		settings.profile = profile;
+		settings.recordThroughput = throughput;
+
+		// Print settings
+		printf("Running simulation for:\n");
+		if (mapFile.empty()) printf("> Map %d\n", settings.mapNumber);
+		else printf("> Map file %s\n", mapFile.c_str());
+		if (settings.numberRobots == 1) printf("> %d robot\n", settings.numberRobots);
+		else printf("> %d robots\n", settings.numberRobots);
+		printf("> %d obstacles\n", settings.numberObstacles);
+		if (twoPhase) printf("> Two-phase ticks\n");
+		printf("> Seed %llu\n\n", (unsigned long long)seed);
+
+		RunResult result = runHeadless(settings, seed, tracePath);
+		runLog.add(settings, 0, result);
+		if (result.completed) printf("Completed!\n");
+		if (result.failed) printf("Failed!\n");
+
+		// Display results
+		printf("Total Ticks: %d\n", result.ticks);
+		if (result.itemsRetrieved > 0) printf("Average ticks per item: %f\n", (float)result.ticks / (float)result.itemsRetrieved);
+		printf("Items retrieved: %d\n", result.itemsRetrieved);
+		printf("Number of dead robots: %d\n", result.numDeadRobots);
+		printf("Simulation run time: %f\n", result.seconds);
+		if (result.profile) {
+			fflush(stdout);
+			result.profile->writeReport(std::cout);
+		}
+		printf("-------------------------------------------\n");
+	}
+	// Time the same map with growing fleets, to see how the cost of a tick grows with the number of robots
+	else if (mode == "scale") {
+		SimSettings settings = testSettingsFor(chosen);
+		settings.maxTicks = 0;
+		if (!mapFile.empty()) settings.mapPath = mapFile;
+		settings.twoPhaseTicks = twoPhase;
+		settings.tickThreads = tickThreads;
+		settings.profile = profile;
+
+		printf("Timing %d %sticks of %s with %d obstacles\n", scaleTicks, twoPhase ? "two-phase " : "", settings.mapPath.c_str(), settings.numberObstacles);
+		printf("Seed: %llu\n\n", (unsigned long long)seed);
+
+		for (int fleet = 100; fleet <= MAX_FLEET; fleet *= 10) {
+			for (int multiple : { 1, 3 }) {
+				if (fleet * multiple > MAX_FLEET) break;
+				settings.numberRobots = fleet * multiple;
+
+				WarehouseSim sim(settings, seed);
+				if (!sim.loadMap()) return 1;
+				sim.spawnRobots();
+				sim.createItemList();
+
+				auto start = std::chrono::steady_clock::now();
+				int ticks = 0;
+				while (ticks < scaleTicks && sim.step()) ticks++;
+				float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+
+				printf("%5d robots: %4d ticks, %9.3f ms per tick, %7.3f us per robot per tick\n", sim.getNumberOfRobots(), ticks, 1000 * seconds / ticks, 1000000 * seconds / ticks / sim.getNumberOfRobots());
+				fflush(stdout);
+				if (profile) {
+					sim.getProfiler().writeReport(std::cout);
+					std::cout << "\n" << std::flush;
+				}
+			}
+		}
+	}
+	// Run variants on from one warmed-up state, so they skip the ticks they would all have in common
+	else if (mode == "fork") {
+		SimSettings settings = testSettingsFor(chosen);
+		settings.maxTicks = 0;
+		if (!mapFile.empty()) settings.mapPath = mapFile;
+		settings.twoPhaseTicks = twoPhase;
+		settings.tickThreads = tickThreads;
+		settings.profile = profile;
+		settings.recordThroughput = throughput;
+
+		auto start = std::chrono::steady_clock::now();
+		std::unique_ptr<WarehouseSim> sim;
+		if (!loadSnapshotPath.empty()) {
+			sim = WarehouseSim::loadSnapshot(loadSnapshotPath);
+			if (sim == nullptr) {
+				printf("Could not load snapshot %s\n", loadSnapshotPath.c_str());
+				return 1;
+			}
+			printf("Loaded %s at tick %d\n", loadSnapshotPath.c_str(), sim->getTicks());
+		}
+		else {
+			sim.reset(new WarehouseSim(settings, seed));
+			if (!sim->loadMap()) return 1;
+			sim->spawnRobots();
+			sim->createItemList();
+			while (sim->getTicks() < forkAt && sim->step());
+			printf("Ran %s with %d robots and %d obstacles to tick %d with seed %llu\n", settings.mapPath.c_str(), sim->getNumberOfRobots(), settings.numberObstacles, sim->getTicks(), (unsigned long long)seed);
+		}
+		float warmupSeconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+		printf("Items retrieved so far: %d\n", sim->getItemsRetrieved());
+		if (sim->isFinished()) printf("The simulation finished before it could be forked\n");
+
+		if (!saveSnapshotPath.empty()) {
+			if (sim->saveSnapshot(saveSnapshotPath)) printf("Saved %s\n", saveSnapshotPath.c_str());
+			else printf("Could not save snapshot %s\n", saveSnapshotPath.c_str());
+		}
+		printf("\n");
+
+		// Variants keep the settings of the state they are forked from, apart from the ones given
+		SimSettings variantSettings = sim->getSettings();
+		if (obstaclesGiven) variantSettings.numberObstacles = chosen.obstacles;
+		variantSettings.twoPhaseTicks = twoPhase;
+		variantSettings.tickThreads = tickThreads;
+		variantSettings.profile = profile;
+		variantSettings.recordThroughput = throughput;
+
+		int forkTicks = sim->getTicks();
+		float totalSeconds = 0;
+		int totalTicks = 0;
+		for (int i = 0; i < variants; i++) {
+			uint64_t variantSeed = mixSeed(seed, (uint64_t)i + 1);
+			auto variantStart = std::chrono::steady_clock::now();
+			std::unique_ptr<WarehouseSim> variant = sim->fork(variantSettings, variantSeed);
+			if (variant == nullptr) {
+				printf("Could not fork the simulation\n");
+				return 1;
+			}
+			while (variant->step());
+			float seconds = std::chrono::duration<float>(std::chrono::steady_clock::now() - variantStart).count();
+			totalSeconds += seconds;
+			totalTicks += variant->getTicks();
+
+			RunResult result;
+			result.seed = variantSeed;
+			result.completed = variant->isCompleted();
+			result.failed = variant->isFailed();
+			result.ticks = variant->getTicks();
+			result.itemsRetrieved = variant->getItemsRetrieved();
+			result.numDeadRobots = variant->getNumDeadRobots();
+			result.seconds = seconds;
+			result.failureReason = variant->getFailureReason();
+			result.throughput = variant->getThroughput();
+			runLog.add(variant->getSettings(), i, result);
+
+			printf("Variant %d (seed %llu): %s, %d ticks, %d items retrieved, %d dead robots, %f seconds\n", i + 1, (unsigned long long)variantSeed, result.completed ? "completed" : "failed", result.ticks, result.itemsRetrieved, result.numDeadRobots, seconds);
+			fflush(stdout);
+			if (profile) variant->getProfiler().writeReport(std::cout);
+		}
+
+		// Every variant would have run the ticks before the fork again if started from the beginning
+		printf("\nAverage ticks taken: %f\n", (float)totalTicks / (float)variants);
+		printf("Ticks skipped by forking: %d of %d (%.1f%%)\n", forkTicks * variants, totalTicks, totalTicks > 0 ? 100.0f * (float)(forkTicks * variants) / (float)totalTicks : 0.0f);
+		printf("Time taken: %f seconds up to the fork and %f seconds for the variants\n", warmupSeconds, totalSeconds);
+	}
+	// Test logical settings or all combinations of settings
+	else {
+		std::vector<SimSettings> settings;
+		for (const TestSetting& setting : (mode == "test") ? logicalTestSettings() : allTestSettings()) {
+			settings.push_back(testSettingsFor(setting));
+			settings.back().profile = profile;
+			settings.back().recordThroughput = throughput;
+		}
+
+		SweepRunner runner(threads);
+		if (adaptive) runner.setAdaptive(maxIterations, precision / 100);
+
+		// Carry on from an interrupted sweep, with the seed it was started with
+		SweepJournal journal;
+		if (!journalPath.empty()) {
+			if (!journal.open(journalPath, seed, runner.getOptions(iterations))) {
+				if (journal.getOptions() != runner.getOptions(iterations)) printf("%s belongs to a sweep with other options (%s); use the same options or another journal\n", journalPath.c_str(), journal.getOptions().empty() ? "unknown" : journal.getOptions().c_str());
+				else printf("Could not open %s\n", journalPath.c_str());
+				return 1;
+			}
+			if (seedGiven && journal.getSweepSeed() != seed) {
+				printf("%s belongs to the sweep with seed %llu\n", journalPath.c_str(), (unsigned long long)journal.getSweepSeed());
+				return 1;
+			}
+			seed = journal.getSweepSeed();
+			runner.setJournal(&journal);
+		}
+		if (!tracesFolder.empty()) {
+			std::error_code error;
+			std::filesystem::create_directories(tracesFolder, error);
+			if (error) {
+				printf("Could not create %s\n", tracesFolder.c_str());
+				return 1;
+			}
+			runner.setTraceFolder(tracesFolder);
+		}
+
+		// Create a file
+		std::ofstream resultsFile(resultsPath.c_str());
+		writeResultsHeader(resultsFile, seed);
+
+		if (adaptive) {
+			printf("Running %d to %d simulations for each of %d combinations of settings, until the ticks per item are within %g%%, on %d threads\n", iterations, maxIterations, (int)settings.size(), precision, runner.getThreads());
+		}
+		else printf("Running %d simulations for %d combinations of settings on %d threads\n", (int)settings.size() * iterations, (int)settings.size(), runner.getThreads());
+		printf("Seed: %llu\n", (unsigned long long)seed);
+		if (journal.getResumedRuns() > 0) printf("Resuming from %s: %d runs already finished\n", journalPath.c_str(), journal.getResumedRuns());
+		printf("\n");
+
+		int totalRuns = 0;
+		runner.run(settings, iterations, seed, [&](int setting, const std::vector<RunResult>& runs, const std::string& stopReason) {
+			writeResults(resultsFile, settings[setting], runs, stopReason);
+			resultsFile.flush();
+
+			int successfulRuns = 0;
+			for (const RunResult& run : runs) {
+				if (run.completed) successfulRuns++;
+			}
+			totalRuns += (int)runs.size();
+			printf("[%d/%d] Map %d, %d robots, %d obstacles: %d/%d successful runs", setting + 1, (int)settings.size(), settings[setting].mapNumber, settings[setting].numberRobots, settings[setting].numberObstacles, successfulRuns, (int)runs.size());
+			if (!stopReason.empty()) printf(" (%s)", stopReason.c_str());
+			printf("\n");
+			fflush(stdout);
+		}, [&](int setting, int iteration, const RunResult& run) {
+			runLog.add(settings[setting], iteration, run);
+		});
+
+		printf("\n%d simulations run in total\n", totalRuns);
+		resultsFile.close();
+	}
+
+	return 0;
+}
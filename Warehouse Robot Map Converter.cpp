@@ -0,0 +1,60 @@
+#include "MapFile.h"
+#include <cstdio>
+#include <string>
+
+void printUsage() {
+	printf("Usage: \"Warehouse Robot Map Converter\" [all | INPUT [OUTPUT]]\n");
+	printf("  all       Convert warehouse_resources/map1.map to map8.map into binary .wmap files (default)\n");
+	printf("  INPUT     Convert one map file, text or binary, into a binary map file\n");
+	printf("  OUTPUT    Binary map file to write (default: INPUT with the extension .wmap)\n");
+}
+
+// Convert a map file into a binary map file; returns false if it could not be converted
+bool convert(const std::string& inputPath, const std::string& outputPath) {
+	MapFile map;
+	if (!map.open(inputPath)) return false;
+
+	if (!writeBinaryMap(outputPath, map.getWidth(), map.getHeight(), map.getTiles())) {
+		printf("Could not write map file %s\n", outputPath.c_str());
+		return false;
+	}
+	printf("%s -> %s (%dx%d tiles)\n", inputPath.c_str(), outputPath.c_str(), map.getWidth(), map.getHeight());
+	return true;
+}
+
+// Path of a map file with its extension replaced by .wmap
+std::string binaryPathOf(const std::string& path) {
+	size_t dot = path.find_last_of('.');
+	size_t slash = path.find_last_of("/\\");
+	if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) return path + ".wmap";
+	else return path.substr(0, dot) + ".wmap";
+}
+
+int main(int argc, char** argv) {
+	if (argc > 3) {
+		printUsage();
+		return 1;
+	}
+
+	// Convert the maps that come with the simulation
+	std::string input = argc > 1 ? argv[1] : "all";
+	if (input == "all" && argc <= 2) {
+		bool success = true;
+		for (int i = 1; i <= 8; i++) {
+			std::string path = "warehouse_resources/map" + std::to_string(i);
+			if (!convert(path + ".map", path + ".wmap")) success = false;
+		}
+		return success ? 0 : 1;
+	}
+	else if (input == "--help" || input == "-h") {
+		printUsage();
+		return 0;
+	}
+
+	std::string output = argc > 2 ? argv[2] : binaryPathOf(input);
+	if (output == input) {
+		printf("The output file must be different from the input file\n");
+		return 1;
+	}
+	return convert(input, output) ? 0 : 1;
+}
@@ -1,67 +1,60 @@
+#include "RunLog.h"
+#include "Sweep.h"
+#include "TraceReplay.h"
 #include <SDL.h>
 #include <SDL_image.h>
 #include <SDL_ttf.h>
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include <fstream>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
-// Number of iterations for each combination of settings when testing
-constexpr int TEST_ITERATIONS = 10;
-
 // Screen sizes
 int SCREEN_WIDTH = 1280;
 int SCREEN_HEIGHT = 720;
 float SCREEN_SCALE = 1.5;
 
-// Number of items to be retrieved
-constexpr int MAX_ITEMS_RETRIEVE = 100;
-int NUMBER_ITEMS_RETRIEVE = MAX_ITEMS_RETRIEVE;
-
-// Tile width and height
-constexpr int WH = 16;
-// Number of tile sprites
-constexpr int TILE_SPRITES = 9;
-// Maximum number of tiles
-constexpr int MAX_TILES = 10000;
-// Map width
-int MAP_WIDTH = 50 * WH;
-int MAP_HEIGHT = 50 * WH;
 // Map number
 int mapNumber = 1;
 // Map name
 std::string mapPath = "warehouse_resources/map1.map";
+// Map width
+int MAP_WIDTH = 50 * WH;
+int MAP_HEIGHT = 50 * WH;
 
-// Number of robot sprites
-constexpr int ROBOT_SPRITES = 4;
-// Maximum number of robots
-constexpr int MAX_ROBOTS = 100;
 // Number of robots
 int NUMBER_ROBOTS = MAX_ROBOTS;
-// Robot battery loss per tick of movement
-float BATTERY_LOSS = (float)0.2;
-// Robot battery gain per tick of charging
-float BATTERY_GAIN = 5;
-// Maximum weight of items that a robot can carry at once
-constexpr int MAX_WEIGHT = 10;
+// Number of obstacles
+int NUMBER_OBSTACLES = MAX_OBSTACLES;
+// Run tests until the ticks per item are precise enough instead of a fixed number of times
+bool ADAPTIVE_TESTS = false;
+
+// Number of robot sprites
+constexpr int ROBOT_SPRITES = 4;
 
 // Number of button sprites
 constexpr int BUTTON_SPRITES = 3;
 // Maximum number of buttons
-constexpr int MAX_BUTTONS = 10;
+constexpr int MAX_BUTTONS = 11;
 
 // Time control
 Uint64 MAX_TICK_INTERVAL = 500;
 Uint64 TICK_INTERVAL = 0;
-
-// Obstacle-generating cooldown in number of ticks
-constexpr int OBSTACLE_CD = 100;
-// Max number of obstacles at a time
-constexpr int MAX_OBSTACLES = 100;
-// Number of obstacles
-int NUMBER_OBSTACLES = MAX_OBSTACLES;
-
+// Longest time in ms the menu waits for input before it is drawn again
+constexpr Uint32 MENU_IDLE_INTERVAL = 500;
+// Time in ms between redraws of the progress of a test
+constexpr Uint32 TEST_PROGRESS_INTERVAL = 250;
+// Replay speed in ticks per second
+int REPLAY_SPEED = 30;
+constexpr int MAX_REPLAY_SPEED = 3840;
+
+// Event trace of the last simulation started from the menu
+const std::string LAST_TRACE_PATH = "simulation trace.wtrace";
 // Initialise window and renderer
 SDL_Window* window;
 SDL_Renderer* renderer;
@@ -116,23 +109,6 @@ public:
 		}
 		return true;
 	}
-	bool loadText(std::string text, TTF_Font* font, SDL_Color textColor = { 255, 255, 255, 255 }) {
-		freeTexture();
-		SDL_Surface* loadedSurface = TTF_RenderText_Solid(font, text.c_str(), textColor);
-		if (loadedSurface == nullptr) {
-			printf("Unable to load text %s! SDL_TTF Error: %s\n", text.c_str(), TTF_GetError());
-			return false;
-		}
-		mTexture = SDL_CreateTextureFromSurface(renderer, loadedSurface);
-		if (mTexture == nullptr) {
-			printf("Unable to create texture from text surface %s! SDL Error: %s\n", text.c_str(), SDL_GetError());
-			return false;
-		}
-		mWidth = loadedSurface->w;
-		mHeight = loadedSurface->h;
-		SDL_FreeSurface(loadedSurface);
-		return true;
-	}
 	void render(float x, float y, SDL_Rect* clip = nullptr, float scale = SCREEN_SCALE, double angle = 0.0, SDL_FPoint* center = nullptr, SDL_RendererFlip flip = SDL_FLIP_NONE, SDL_Color maskColor = { 255, 255, 255, 255 }) {
 		// Screen scaling
 		SDL_FRect dest = { x * scale, y * scale , (float)mWidth * scale, (float)mHeight * scale };
@@ -164,898 +140,246 @@ private:
 	int mWidth; int mHeight;
 };
 
-// Textures
-DTexture robotTexture;
-DTexture tilesTexture;
-DTexture textTexture;
-DTexture buttonTexture;
-DTexture blackScreenTexture;
-
-// Texture clips
-SDL_Rect robotTextureClips[ROBOT_SPRITES];
-SDL_Rect tilesTextureClips[TILE_SPRITES];
-SDL_Rect buttonTextureClips[BUTTON_SPRITES];
-SDL_Rect blackScreenTextureClip = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
-
-// Text
-std::stringstream textObj;
-
-// Function to render small text
-void renderText(std::string text, float x, float y, bool center = false, bool shadow = false, SDL_Color textColor = { 255, 255, 255, 255 }) {
-	if (center) {
-		textTexture.loadText(text, pixellari);
-		x -= (float)textTexture.getWidth() / 2;
-		y -= (float)textTexture.getHeight() / (float)2.5;
-	}
-
-	// Render text shadow if required
-	if (shadow) {
-		textTexture.loadText(text, pixellari, { 0, 0, 0, 255 });
-		textTexture.render(x + (float)FONT_SIZE / 16, y + (float)FONT_SIZE / 16, nullptr, 1);
-	}
-
-	// Load and render text
-	textTexture.loadText(text, pixellari, textColor);
-	textTexture.render(x, y, nullptr, 1);
-}
-
-// Function to render medium text
-void renderTextMedium(std::string text, float x, float y, bool center = false, bool shadow = false, SDL_Color textColor = { 255, 255, 255, 255 }) {
-	if (center) {
-		textTexture.loadText(text, pixellari_medium);
-		x -= (float)textTexture.getWidth() / 2;
-		y -= (float)textTexture.getHeight() / (float)2.5;
-	}
-
-	// Render text shadow if required
-	if (shadow) {
-		textTexture.loadText(text, pixellari_medium, { 0, 0, 0, 255 });
-		textTexture.render(x + (float)FONT_SIZE / 16, y + (float)FONT_SIZE / 16, nullptr, 1);
-	}
-
-	// Load and render text
-	textTexture.loadText(text, pixellari_medium, textColor);
-	textTexture.render(x, y, nullptr, 1);
-}
-
-// Function to render titles
-void renderTitle(std::string text, float x, float y, bool center = false, bool shadow = false, SDL_Color textColor = { 255, 255, 255, 255 }) {
-	if (center) {
-		textTexture.loadText(text, pixellari_title);
-		x -= (float)textTexture.getWidth() / 2;
-		y -= (float)textTexture.getHeight() / (float)2.5;
-	}
-
-	// Render text shadow if required
-	if (shadow) {
-		textTexture.loadText(text, pixellari_title, { 0, 0, 0, 255 });
-		textTexture.render(x + (float)FONT_SIZE / 16, y + (float)FONT_SIZE / 16, nullptr, 1);
-	}
-
-	// Load and render text
-	textTexture.loadText(text, pixellari_title, textColor);
-	textTexture.render(x, y, nullptr, 1);
-}
-
-// Tile class
-class Tile {
+// Every printable ASCII character of a font rasterised once into a single texture
+// Text is drawn glyph by glyph from it, so nothing is rasterised or uploaded again after the fonts are loaded
+class GlyphAtlas {
 public:
-	Tile(float x, float y, int setType = -1, int setItem = -1, int setWeight = -1) {
-		hitbox = { x, y, WH, WH };
-		type = setType;
-
-		if (type >= 2 && type <= 5) {
-			item = setItem;
-			weight = setWeight;
-		}
-		else {
-			item = -1;
-			weight = -1;
-		}
+	~GlyphAtlas() {
+		freeTexture();
 	}
-	void render(SDL_FRect& camera) {
-		if (type > 0) {
-			if (SDL_HasIntersectionF(&hitbox, &camera)) {
-				tilesTexture.render(hitbox.x - camera.x, hitbox.y - camera.y, &tilesTextureClips[type - 1]);
-			}
+	void freeTexture() {
+		if (mTexture != nullptr) {
+			SDL_DestroyTexture(mTexture);
+			mTexture = nullptr;
 		}
 	}
-
-	// Get functions
-	SDL_FRect getBox() {
-		return hitbox;
-	}
-	float getX() {
-		return hitbox.x;
-	}
-	float getY() {
-		return hitbox.y;
-	}
-	int getType() {
-		return type;
-	}
-	int getItem() {
-		return item;
-	}
-	int getWeight() {
-		return weight;
-	}
-
-	// Set functions
-	void setTileType(int setType) {
-		type = setType;
-	}
-	void setItem(int setShelfItem) {
-		item = setShelfItem;
-	}
-	void setWeight(int setShelfWeight) {
-		weight = setShelfWeight;
-	}
-private:
-	SDL_FRect hitbox;
-	int type;
-	int item;	// Item held by shelves; -1 if no item or not a shelf
-	int weight; // The weight of the item
-};
-
-// Get weight of an item
-int weightOf(int item) {
-	int result = item % MAX_WEIGHT;
-	if (result == 0) result = MAX_WEIGHT;
-	return result;
-}
-
-// Robot class
-class Robot {
-public:
-	Robot(float x, float y, int direction = 1, float setBattery = 100, int setItems[MAX_WEIGHT] = nullptr) {
-		hitbox = { x, y, WH, WH };
-		weightBar = { 0, -20, WH, 5 };
-		battery = setBattery;
-		sprite = 3;
-		dir = 1;
-		weight = 0;
-		if (setItems == nullptr) {
-			for (int i = 0; i < MAX_WEIGHT; i++) {
-				items[i] = 0;
-			}
+	bool load(TTF_Font* font) {
+		freeTexture();
+		mFont = font;
+		mHeight = TTF_FontHeight(font);
+
+		// Rasterise each character in white on its own, so the texture can be tinted to any colour
+		SDL_Surface* glyphSurfaces[GLYPHS] = {};
+		int cellWidth = 1;
+		for (int i = 0; i < GLYPHS; i++) {
+			char text[2] = { (char)(FIRST_GLYPH + i), '\0' };
+			int minX = 0, maxX = 0, minY = 0, maxY = 0, advance = 0;
+			TTF_GlyphMetrics(font, (Uint16)text[0], &minX, &maxX, &minY, &maxY, &advance);
+			mGlyphs[i].advance = advance;
+			mGlyphs[i].offset = std::min(minX, 0);
+			glyphSurfaces[i] = TTF_RenderText_Solid(font, text, { 255, 255, 255, 255 });
+			if (glyphSurfaces[i] != nullptr) cellWidth = std::max(cellWidth, glyphSurfaces[i]->w);
 		}
-		else {
-			for (int i = 0; i < MAX_WEIGHT; i++) {
-				items[i] = setItems[i];
-				weight += setItems[i];
+
+		// Copy the characters into a grid on one surface
+		SDL_Surface* atlasSurface = SDL_CreateRGBSurfaceWithFormat(0, cellWidth * ATLAS_COLUMNS, mHeight * ((GLYPHS + ATLAS_COLUMNS - 1) / ATLAS_COLUMNS), 32, SDL_PIXELFORMAT_RGBA32);
+		for (int i = 0; i < GLYPHS; i++) {
+			mGlyphs[i].clip = { i % ATLAS_COLUMNS * cellWidth, i / ATLAS_COLUMNS * mHeight, 0, 0 };
+			if (glyphSurfaces[i] != nullptr) {
+				mGlyphs[i].clip.w = glyphSurfaces[i]->w;
+				mGlyphs[i].clip.h = glyphSurfaces[i]->h;
+				SDL_Rect dest = mGlyphs[i].clip;
+				if (atlasSurface != nullptr) SDL_BlitSurface(glyphSurfaces[i], nullptr, atlasSurface, &dest);
+				SDL_FreeSurface(glyphSurfaces[i]);
 			}
 		}
-
-		for (int i = 0; i < MAX_TILES; i++) {
-			visitHistory[i] = 0;
+		if (atlasSurface == nullptr) {
+			printf("Unable to create glyph atlas surface! SDL Error: %s\n", SDL_GetError());
+			return false;
 		}
-	}
-	void render(SDL_FRect& camera) {
-		if (SDL_HasIntersectionF(&hitbox, &camera)) {
-			SDL_FPoint point = { hitbox.x, hitbox.y };
-			switch (dir) {
-			case 0:	robotTexture.render(hitbox.x - camera.x, hitbox.y - camera.y, &robotTextureClips[sprite], SCREEN_SCALE); break;
-			case 1:	robotTexture.render(hitbox.x - camera.x, hitbox.y - camera.y, &robotTextureClips[sprite], SCREEN_SCALE, 180); break;
-			case 2:	robotTexture.render(hitbox.x - camera.x, hitbox.y - camera.y, &robotTextureClips[sprite], SCREEN_SCALE, 270); break;
-			case 3:	robotTexture.render(hitbox.x - camera.x, hitbox.y - camera.y, &robotTextureClips[sprite], SCREEN_SCALE, 90); break;
-			}
 
-			// Set weight bar size
-			weightBar = { hitbox.x - camera.x, hitbox.y - 5 - camera.y, WH * (float)weight / (float)MAX_WEIGHT, 4 };
-			weightBar.x *= SCREEN_SCALE;
-			weightBar.y *= SCREEN_SCALE;
-			weightBar.w *= SCREEN_SCALE;
-			weightBar.h *= SCREEN_SCALE;
-			// Render weight bar
-			SDL_SetRenderDrawColor(renderer, 0x46, 0xa2, 0xFF, 0xFF);
-			SDL_RenderFillRectF(renderer, &weightBar);
+		mTexture = SDL_CreateTextureFromSurface(renderer, atlasSurface);
+		SDL_FreeSurface(atlasSurface);
+		if (mTexture == nullptr) {
+			printf("Unable to create glyph atlas texture! SDL Error: %s\n", SDL_GetError());
+			return false;
 		}
+		SDL_SetTextureBlendMode(mTexture, SDL_BLENDMODE_BLEND);
+		return true;
 	}
-
-	// Get functions
-	SDL_FRect getBox() {
-		return hitbox;
-	}
-	int getTile(Tile* tiles[]) {
-		for (int i = 0; i < MAX_TILES; i++) {
-			if (tiles[i] != nullptr) {
-				if (tiles[i]->getX() == hitbox.x && tiles[i]->getY() == hitbox.y) return i;
-			}
+	// Width of a line of text in pixels
+	int getWidth(const std::string& text) {
+		int width = 0;
+		int previous = -1;
+		for (char c : text) {
+			int glyph = glyphIndex(c);
+			width += kerning(previous, glyph) + mGlyphs[glyph].advance;
+			previous = glyph;
 		}
-		return 0;
-	}
-	int getItem(int index) {
-		return items[index];
-	}
-	int* getItems() {
-		return items;
-	}
-	int getWeight() {
-		return weight;
+		return width;
 	}
-	float getBattery() {
-		return battery;
-	}
-	int getDir() {
-		return dir;
-	}
-	int getHistory(int index) {
-		if (index >= 0 && index <= MAP_WIDTH * MAP_HEIGHT / WH / WH) return visitHistory[index];
-		else return 0;
+	int getHeight() {
+		return mHeight;
 	}
-
-	void addItem(int item) {
-		// Add this item to the robot
-		if (item != 0) {
-			for (int i = 0; i < MAX_WEIGHT; i++) {
-				if (items[i] == 0) {
-					items[i] = item;
-					weight += weightOf(item);
-					break;
-				}
+	void render(const std::string& text, float x, float y, SDL_Color textColor) {
+		if (mTexture == nullptr) return;
+		SDL_SetTextureColorMod(mTexture, textColor.r, textColor.g, textColor.b);
+		SDL_SetTextureAlphaMod(mTexture, textColor.a);
+
+		int penX = 0;
+		int previous = -1;
+		for (char c : text) {
+			int glyph = glyphIndex(c);
+			penX += kerning(previous, glyph);
+			const SDL_Rect& clip = mGlyphs[glyph].clip;
+			if (clip.w > 0) {
+				SDL_FRect dest = { x + (float)(penX + mGlyphs[glyph].offset), y, (float)clip.w, (float)clip.h };
+				SDL_RenderCopyF(renderer, mTexture, &clip, &dest);
 			}
+			penX += mGlyphs[glyph].advance;
+			previous = glyph;
 		}
 	}
-	void clearItems() {
-		for (int i = 0; i < MAX_WEIGHT; i++) items[i] = 0;
-		
-		weight = 0;
-	}
-
-	// Set functions
-	void setXY(float x, float y) {
-		hitbox.x = x;
-		hitbox.y = y;
-	}
-	void setDir(int direction) {
-		dir = direction;
-	}
-	void setBattery(float batteryLevel) {
-		battery = batteryLevel;
-
-		if (battery < 0) battery = 0;
-
-		// Set sprite based on battery
-		if (battery == 0) sprite = 0;
-		else if (battery < 20) sprite = 1;
-		else if (battery < 50) sprite = 2;
-	}
-
-	// Actions
-	bool turn(int direction) {
-		if (battery > 0 && dir != direction) {
-			dir = direction;
-
-			// Decrement battery
-			battery -= BATTERY_LOSS;
-			if (battery < 0) battery = 0;
-
-			// Set sprite based on battery
-			if (battery == 0) sprite = 0;
-			else if (battery < 20) sprite = 1;
-			else if (battery < 50) sprite = 2;
-
-			return true;
-		}
-		else return false;
-	}
-	bool move(Tile* tiles[], Robot* robots[]) {
-		bool success = true;
-
-		if (battery > 0 && weight <= MAX_WEIGHT) {
-			// Move robot
-			switch (dir) {
-			case 0: hitbox.y -= WH; break;
-			case 1: hitbox.y += WH; break;
-			case 2: hitbox.x -= WH; break;
-			case 3: hitbox.x += WH; break;
-			}
+private:
+	static constexpr int FIRST_GLYPH = ' ';
+	static constexpr int GLYPHS = '~' - ' ' + 1;
+	static constexpr int ATLAS_COLUMNS = 16;
+
+	struct Glyph {
+		SDL_Rect clip;
+		int advance;
+		int offset; // Shift of a character that starts left of where it is drawn
+	};
+
+	// Characters outside the atlas are drawn as question marks
+	static int glyphIndex(char c) {
+		if (c < FIRST_GLYPH || c >= FIRST_GLYPH + GLYPHS) c = '?';
+		return c - FIRST_GLYPH;
+	}
+	int kerning(int previous, int glyph) {
+		if (previous < 0) return 0;
+		return TTF_GetFontKerningSizeGlyphs(mFont, (Uint16)(FIRST_GLYPH + previous), (Uint16)(FIRST_GLYPH + glyph));
+	}
+
+	SDL_Texture* mTexture = nullptr;
+	TTF_Font* mFont = nullptr;
+	int mHeight = 0;
+	Glyph mGlyphs[GLYPHS] = {};
+};
 
-			// Set flag to cancel robot movement if it would collide with something
-			if (hitbox.x < 0 || hitbox.x > MAP_WIDTH - WH) success = false;
-			else if (hitbox.y < 0 || hitbox.y > MAP_HEIGHT - WH) success = false;
-			else {
-				for (int i = 0; i < MAX_TILES; i++) {
-					if (tiles[i] != nullptr) {
-						if (tiles[i]->getType() != 1 && (tiles[i]->getType() < 6 || tiles[i]->getType() > 8)) {
-							SDL_FRect tileHitbox = tiles[i]->getBox();
-							if (SDL_HasIntersectionF(&tileHitbox, &hitbox)) {
-								success = false;
-								break;
-							}
-						}
-					}
-				}
+// Textures
+DTexture robotTexture;
+DTexture tilesTexture;
+DTexture buttonTexture;
+DTexture blackScreenTexture;
 
-				int instances = 0;
-				if (success) {
-					for (int i = 0; i < NUMBER_ROBOTS; i++) {
-						if (robots[i] != nullptr) {
-							SDL_FRect robotHitbox = robots[i]->getBox();
-							SDL_FRect selfHitbox = hitbox;
-
-							if (SDL_HasIntersectionF(&robotHitbox, &selfHitbox)) {
-								instances++;
-							}
-
-							// If hit itself + another robot
-							if (instances > 1) {
-								success = false;
-								break;
-							}
-						}
-					}
-				}
-			}
+// Texture clips
+SDL_Rect robotTextureClips[ROBOT_SPRITES];
+SDL_Rect tilesTextureClips[TILE_SPRITES];
+SDL_Rect buttonTextureClips[BUTTON_SPRITES];
+SDL_Rect blackScreenTextureClip = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
 
-			// Cancel robot movement
-			if (!success) {
-				switch (dir) {
-				case 0: hitbox.y += WH; break;
-				case 1: hitbox.y -= WH; break;
-				case 2: hitbox.x += WH; break;
-				case 3: hitbox.x -= WH; break;
-				}
-			}
-			// decrement battery
-			else {
-				battery -= BATTERY_LOSS;
-				if (battery < 0) battery = 0;
+// Text
+std::stringstream textObj;
 
-				// Set sprite based on battery
-				if (battery == 0) sprite = 0;
-				else if (battery < 20) sprite = 1;
-				else if (battery < 50) sprite = 2;
-			}
-		}
-		else success = false;
+// Glyph atlases of the fonts
+GlyphAtlas textAtlas;
+GlyphAtlas textMediumAtlas;
+GlyphAtlas titleAtlas;
 
-		// Returns true if moved successfully
-		return success;
+// Renders text from a glyph atlas
+void renderAtlasText(GlyphAtlas& atlas, const std::string& text, float x, float y, bool center, bool shadow, SDL_Color textColor) {
+	if (center) {
+		x -= (float)atlas.getWidth(text) / 2;
+		y -= (float)atlas.getHeight() / (float)2.5;
 	}
-	bool takeShelfItem(Tile* tiles[], int predItemList[]) {
-		int currentTile = getTile(tiles);
-		int map_width = MAP_WIDTH / WH;
-		int map_height = MAP_HEIGHT / WH;
-
-		switch (dir) {
-		case 0: // Up
-			// Check within bounds
-			if (currentTile - map_width > 0 && tiles[currentTile - map_width] != nullptr) {
-				if (tiles[currentTile - map_width] != nullptr) {
-					// Check that the tile above is a bottom-facing shelf
-					if (tiles[currentTile - map_width]->getType() == 3) {
-						// Check that the robot can still hold this item
-						if (weight + tiles[currentTile - map_width]->getWeight() > MAX_WEIGHT) return false;
-
-						// Remove this item from the predicted item list
-						for (int i = 0; i < NUMBER_ITEMS_RETRIEVE; i++) {
-							if (tiles[currentTile - map_width]->getItem() == predItemList[i]) {
-								predItemList[i] = 0;
-								break;
-							}
-						}
 
-						// Take an item
-						addItem(tiles[currentTile - map_width]->getItem());
-					}
-					else return false;
-				}
-				else return false;
-			}
-			break;
-		case 1: // Down
-			// Check within bounds
-			if (currentTile + map_width < map_width * map_height && tiles[currentTile + map_width] != nullptr) {
-				if (tiles[currentTile + map_width] != nullptr) {
-					// Check that the tile below is a top-facing shelf
-					if (tiles[currentTile + map_width]->getType() == 2) {
-						// Check that the robot can still hold this item
-						if (weight + tiles[currentTile + map_width]->getWeight() > MAX_WEIGHT) return false;
-
-						// Remove this item from the predicted item list
-						for (int i = 0; i < NUMBER_ITEMS_RETRIEVE; i++) {
-							if (tiles[currentTile + map_width]->getItem() == predItemList[i]) {
-								predItemList[i] = 0;
-								break;
-							}
-						}
-
-						// Take an item
-						addItem(tiles[currentTile + map_width]->getItem());
-					}
-					else return false;
-				}
-				else return false;
-			}
-			break;
-		case 2: // Left
-			// Check within bounds
-			if (currentTile % map_width > 0 && tiles[currentTile - 1] != nullptr) {
-				if (tiles[currentTile - 1] != nullptr) {
-					// Check that the tile to the left is a right-facing shelf
-					if (tiles[currentTile - 1]->getType() == 5) {
-						// Check that the robot can still hold this item
-						if (weight + tiles[currentTile - 1]->getWeight() > MAX_WEIGHT) return false;
-
-						// Remove this item from the predicted item list
-						for (int i = 0; i < NUMBER_ITEMS_RETRIEVE; i++) {
-							if (tiles[currentTile - 1]->getItem() == predItemList[i]) {
-								predItemList[i] = 0;
-								break;
-							}
-						}
-
-						// Take an item
-						addItem(tiles[currentTile - 1]->getItem());
-					}
-					else return false;
-				}
-				else return false;
-			}
-			break;
-		case 3: // Right
-			// Check within bounds
-			if (currentTile % map_width < map_width - 1 && tiles[currentTile + 1] != nullptr) {
-				if (tiles[currentTile + 1] != nullptr) {
-					// Check that the tile to the right is a left-facing shelf
-					if (tiles[currentTile + 1]->getType() == 4) {
-						// Check that the robot can still hold this item
-						if (weight + tiles[currentTile + 1]->getWeight() > MAX_WEIGHT) return false;
-
-						// Remove this item from the predicted item list
-						for (int i = 0; i < NUMBER_ITEMS_RETRIEVE; i++) {
-							if (tiles[currentTile + 1]->getItem() == predItemList[i]) {
-								predItemList[i] = 0;
-								break;
-							}
-						}
-
-						// Take an item
-						addItem(tiles[currentTile + 1]->getItem());
-					}
-					else return false;
-				}
-				else return false;
-			}
-			break;
-		}
-
-		battery -= BATTERY_LOSS;
-		if (battery < 0) battery = 0;
-
-		// Set sprite based on battery
-		if (battery == 0) sprite = 0;
-		else if (battery < 20) sprite = 1;
-		else if (battery < 50) sprite = 2;
-
-		return true;
-	}
-	bool takeRobotItem(Tile* tiles[], Robot* robots[]) {
-		bool success = false;
+	// Render text shadow if required
+	if (shadow) atlas.render(text, x + (float)FONT_SIZE / 16, y + (float)FONT_SIZE / 16, { 0, 0, 0, 255 });
 
-		int currentTile = getTile(tiles);
-		int map_width = MAP_WIDTH / WH;
-		int map_height = MAP_HEIGHT / WH;
+	// Render text
+	atlas.render(text, x, y, textColor);
+}
 
-		switch (dir) {
-		case 0: // Up
-			// Check that there is a robot above
-			for (int i = 0; i < NUMBER_ROBOTS; i++) {
-				if (robots[i] != nullptr) {
-					if (robots[i]->getBox().x == hitbox.x && robots[i]->getBox().y == hitbox.y - WH) {
-						// If we have nothing on hand
-						if (weight == 0) {
-							// Add all of the dead robot's items to our hand
-							for (int j = 0; j < MAX_WEIGHT; j++) addItem(robots[i]->getItem(j));
-
-							// Clear the dead robot's hand
-							robots[i]->clearItems();
-							success = true;
-							break;
-						}
-					}
-				}
-			}
-			break;
-		case 1: // Down
-			// Check that there is a robot below
-			for (int i = 0; i < NUMBER_ROBOTS; i++) {
-				if (robots[i] != nullptr) {
-					if (robots[i]->getBox().x == hitbox.x && robots[i]->getBox().y == hitbox.y + WH) {
-						// If we have nothing on hand
-						if (weight == 0) {
-							// Add all of the dead robot's items to our hand
-							for (int j = 0; j < MAX_WEIGHT; j++) addItem(robots[i]->getItem(j));
-
-							// Clear the dead robot's hand
-							robots[i]->clearItems();
-							success = true;
-							break;
-						}
-					}
-				}
-			}
-			break;
-		case 2: // Left
-			// Check that there is a robot to the left
-			for (int i = 0; i < NUMBER_ROBOTS; i++) {
-				if (robots[i] != nullptr) {
-					if (robots[i]->getBox().x == hitbox.x - WH && robots[i]->getBox().y == hitbox.y) {
-						// If we have nothing on hand
-						if (weight == 0) {
-							// Add all of the dead robot's items to our hand
-							for (int j = 0; j < MAX_WEIGHT; j++) addItem(robots[i]->getItem(j));
-
-							// Clear the dead robot's hand
-							robots[i]->clearItems();
-							success = true;
-							break;
-						}
-					}
-				}
-			}
-			break;
-		case 3: // Right
-			// Check that there is a robot to the right
-			for (int i = 0; i < NUMBER_ROBOTS; i++) {
-				if (robots[i] != nullptr) {
-					if (robots[i]->getBox().x == hitbox.x + WH && robots[i]->getBox().y == hitbox.y) {
-						// If we have nothing on hand
-						if (weight == 0) {
-							// Add all of the dead robot's items to our hand
-							for (int j = 0; j < MAX_WEIGHT; j++) addItem(robots[i]->getItem(j));
-
-							// Clear the dead robot's hand
-							robots[i]->clearItems();
-							success = true;
-							break;
-						}
-					}
-				}
-			}
-			break;
-		}
+// Function to render small text
+void renderText(const std::string& text, float x, float y, bool center = false, bool shadow = false, SDL_Color textColor = { 255, 255, 255, 255 }) {
+	renderAtlasText(textAtlas, text, x, y, center, shadow, textColor);
+}
 
-		if (success) {
-			// Decrement battery
-			battery -= BATTERY_LOSS;
-			if (battery < 0) battery = 0;
+// Function to render medium text
+void renderTextMedium(const std::string& text, float x, float y, bool center = false, bool shadow = false, SDL_Color textColor = { 255, 255, 255, 255 }) {
+	renderAtlasText(textMediumAtlas, text, x, y, center, shadow, textColor);
+}
 
-			// Set sprite based on battery
-			if (battery == 0) sprite = 0;
-			else if (battery < 20) sprite = 1;
-			else if (battery < 50) sprite = 2;
-		}
-		
-		return success;
-	}
-	bool charge(Tile* tiles[]) {
-		// If standing on a charger tile, increase battery level
-		if (tiles[getTile(tiles)] != nullptr) {
-			if (tiles[getTile(tiles)]->getType() == 6) {
-				battery += BATTERY_GAIN;
-				if (battery > 100) battery = 100;
-
-				// Set sprite based on battery
-				if (battery == 0) sprite = 0;
-				else if (battery < 20) sprite = 1;
-				else if (battery < 50) sprite = 2;
-				else sprite = 3;
-
-				return true;
-			}
-		}
-		return false;
-	}
-	bool passItem(Robot* robots[], Tile* tiles[], int item) {
-		int currentTile = getTile(tiles);
-		int map_width = MAP_WIDTH / WH;
-		int map_height = MAP_HEIGHT / WH;
-
-		switch (dir) {
-		case 0: // Up
-			// Check within bounds
-			if (currentTile - map_width > 0 && tiles[currentTile - map_width] != nullptr) {
-				// Check that there is a robot above
-				for (int i = 0; i < NUMBER_ROBOTS; i++) {
-					if (robots[i] != nullptr) {
-						// If this is the right robot
-						if (robots[i]->getBox().x == hitbox.x && robots[i]->getBox().y == hitbox.y - WH) {
-							// If that robot has room for the item
-							if (robots[i]->getWeight() <= MAX_WEIGHT - weightOf(item)) {
-								// Remove item from this robot
-								for (int j = 0; j < MAX_WEIGHT; j++) {
-									if (items[j] == item) {
-										items[j] = 0;
-										weight -= weightOf(item);
-										break;
-									}
-								}
-
-								// Pass the item to that robot
-								robots[i]->addItem(item);
-
-								battery -= BATTERY_LOSS;
-								if (battery < 0) battery = 0;
-
-								// Set sprite based on battery
-								if (battery == 0) sprite = 0;
-								else if (battery < 20) sprite = 1;
-								else if (battery < 50) sprite = 2;
-
-								return true;
-							}
-							break;
-						}
-					}
-				}
-			}
-			break;
-		case 1: // Down
-			// Check within bounds
-			if (currentTile + map_width < map_width * map_height && tiles[currentTile + map_width] != nullptr) {
-				// Check that there is a robot below
-				for (int i = 0; i < NUMBER_ROBOTS; i++) {
-					if (robots[i] != nullptr) {
-						// If this is the right robot
-						if (robots[i]->getBox().x == hitbox.x && robots[i]->getBox().y == hitbox.y + WH) {
-							// If that robot has room for the item
-							if (robots[i]->getWeight() <= MAX_WEIGHT - item) {
-								// Remove item from this robot
-								for (int j = 0; j < MAX_WEIGHT; j++) {
-									if (items[j] == item) {
-										items[j] = 0;
-										weight -= item;
-										break;
-									}
-								}
-
-								// Pass the item to that robot
-								robots[i]->addItem(item);
-
-								battery -= BATTERY_LOSS;
-								if (battery < 0) battery = 0;
-
-								// Set sprite based on battery
-								if (battery == 0) sprite = 0;
-								else if (battery < 20) sprite = 1;
-								else if (battery < 50) sprite = 2;
-
-								return true;
-							}
-							break;
-						}
-					}
-				}
-			}
-			break;
-		case 2: // Left
-			if (currentTile % map_width > 0 && tiles[currentTile - 1] != nullptr) {
-				// Check that there is a robot to the left
-				for (int i = 0; i < NUMBER_ROBOTS; i++) {
-					if (robots[i] != nullptr) {
-						// If this is the right robot
-						if (robots[i]->getBox().x == hitbox.x - WH && robots[i]->getBox().y == hitbox.y) {
-							// If that robot has room for the item
-							if (robots[i]->getWeight() <= MAX_WEIGHT - item) {
-								// Remove item from this robot
-								for (int j = 0; j < MAX_WEIGHT; j++) {
-									if (items[j] == item) {
-										items[j] = 0;
-										weight -= item;
-										break;
-									}
-								}
-
-								// Pass the item to that robot
-								robots[i]->addItem(item);
-
-								battery -= BATTERY_LOSS;
-								if (battery < 0) battery = 0;
-
-								// Set sprite based on battery
-								if (battery == 0) sprite = 0;
-								else if (battery < 20) sprite = 1;
-								else if (battery < 50) sprite = 2;
-
-								return true;
-							}
-							break;
-						}
-					}
-				}
-			}
-			break;
-		case 3: // Right
-			if (currentTile % map_width < map_width - 1 && tiles[currentTile + 1] != nullptr) {
-				// Check that there is a robot to the left
-				for (int i = 0; i < NUMBER_ROBOTS; i++) {
-					if (robots[i] != nullptr) {
-						// If this is the right robot
-						if (robots[i]->getBox().x == hitbox.x + WH && robots[i]->getBox().y == hitbox.y) {
-							// If that robot has room for the item
-							if (robots[i]->getWeight() <= MAX_WEIGHT - item) {
-								// Remove item from this robot
-								for (int j = 0; j < MAX_WEIGHT; j++) {
-									if (items[j] == item) {
-										items[j] = 0;
-										weight -= item;
-										break;
-									}
-								}
-
-								// Pass the item to that robot
-								robots[i]->addItem(item);
-
-								battery -= BATTERY_LOSS;
-								if (battery < 0) battery = 0;
-
-								// Set sprite based on battery
-								if (battery == 0) sprite = 0;
-								else if (battery < 20) sprite = 1;
-								else if (battery < 50) sprite = 2;
-
-								return true;
-							}
-							break;
-						}
-					}
-				}
-			}
-			break;
-		}
+// Function to render titles
+void renderTitle(const std::string& text, float x, float y, bool center = false, bool shadow = false, SDL_Color textColor = { 255, 255, 255, 255 }) {
+	renderAtlasText(titleAtlas, text, x, y, center, shadow, textColor);
+}
 
-		return false;
-	}
-	bool submitItems(Tile* tiles[], int itemList[]) {
-		bool success = false;
-		// If standing on a submission tile
-		if (tiles[getTile(tiles)] != nullptr) {
-			if (tiles[getTile(tiles)]->getType() == 8) {
-				for (int j = 0; j < MAX_WEIGHT; j++) {
-					if (items[j] != 0) {
-						for (int i = 0; i < NUMBER_ITEMS_RETRIEVE; i++) {
-							if (itemList[i] != 0 && items[j] == itemList[i]) {
-								// Submit the item
-								weight -= weightOf(items[j]);
-								items[j] = 0;
-								itemList[i] = 0;
-
-								success = true;
-							}
-						}
-					}
-				}
-			}
-		}
-		if (success) {
-			// Decrement battery
-			battery -= BATTERY_LOSS;
-			if (battery < 0) battery = 0;
-
-			// Set sprite based on battery
-			if (battery == 0) sprite = 0;
-			else if (battery < 20) sprite = 1;
-			else if (battery < 50) sprite = 2;
+// Renders a tile
+void renderTile(const TileGrid& tiles, int index, SDL_FRect& camera) {
+	if (tiles.getType(index) > 0) {
+		SDL_FRect hitbox = { tiles.getX(index), tiles.getY(index), WH, WH };
+		if (SDL_HasIntersectionF(&hitbox, &camera)) {
+			tilesTexture.render(hitbox.x - camera.x, hitbox.y - camera.y, &tilesTextureClips[tiles.getType(index) - 1]);
 		}
-
-		return success;
 	}
+}
 
-	void sight(Tile* tiles[], Tile* tileDatabase[]) {
-		int currentTile = getTile(tiles);
-		int sightRange = 10 + 1;
-		int map_width = MAP_WIDTH / WH;
-		int map_height = MAP_HEIGHT / WH;
-
-		// Record tiles around the robot
-		// Up
-		if (currentTile - map_width >= 0) {
-			if (tiles[currentTile - map_width] != nullptr) {
-				tileDatabase[currentTile - map_width]->setTileType(tiles[currentTile - map_width]->getType());
-				tileDatabase[currentTile - map_width]->setItem(tiles[currentTile - map_width]->getItem());
-				tileDatabase[currentTile - map_width]->setWeight(tiles[currentTile - map_width]->getWeight());
-			}
-		}
-		// Down
-		if (currentTile + map_width < map_width * map_height) {
-			if (tiles[currentTile - map_width] != nullptr) {
-				tileDatabase[currentTile + map_width]->setTileType(tiles[currentTile + map_width]->getType());
-				tileDatabase[currentTile + map_width]->setItem(tiles[currentTile + map_width]->getItem());
-				tileDatabase[currentTile + map_width]->setWeight(tiles[currentTile + map_width]->getWeight());
-			}
-		}
-		// Left
-		if (currentTile % map_width != 0) {
-			if (tiles[currentTile - 1] != nullptr) {
-				tileDatabase[currentTile - 1]->setTileType(tiles[currentTile - 1]->getType());
-				tileDatabase[currentTile - 1]->setItem(tiles[currentTile - 1]->getItem());
-				tileDatabase[currentTile - 1]->setWeight(tiles[currentTile - 1]->getWeight());
-			}
-		}
-		// Right
-		if (currentTile % map_width != map_width - 1) {
-			if (tiles[currentTile - 1] != nullptr) {
-				tileDatabase[currentTile + 1]->setTileType(tiles[currentTile + 1]->getType());
-				tileDatabase[currentTile + 1]->setItem(tiles[currentTile + 1]->getItem());
-				tileDatabase[currentTile + 1]->setWeight(tiles[currentTile + 1]->getWeight());
-			}
+// Renders a robot and its weight bar
+void renderRobot(Robot* robot, SDL_FRect& camera) {
+	SDL_FRect hitbox = { robot->getBox().x, robot->getBox().y, WH, WH };
+	if (SDL_HasIntersectionF(&hitbox, &camera)) {
+		int sprite = robot->getSprite();
+		switch (robot->getDir()) {
+		case 0:	robotTexture.render(hitbox.x - camera.x, hitbox.y - camera.y, &robotTextureClips[sprite], SCREEN_SCALE); break;
+		case 1:	robotTexture.render(hitbox.x - camera.x, hitbox.y - camera.y, &robotTextureClips[sprite], SCREEN_SCALE, 180); break;
+		case 2:	robotTexture.render(hitbox.x - camera.x, hitbox.y - camera.y, &robotTextureClips[sprite], SCREEN_SCALE, 270); break;
+		case 3:	robotTexture.render(hitbox.x - camera.x, hitbox.y - camera.y, &robotTextureClips[sprite], SCREEN_SCALE, 90); break;
 		}
 
-		// Record tiles up to 10 tiles ahead of the robot
-		bool stop = false;
-		for (int i = 0; i < sightRange && !stop; i++) {
-			if (tiles[currentTile] != nullptr) {
-				// Record tile in database
-				if (tileDatabase[currentTile] != nullptr) {
-					tileDatabase[currentTile]->setTileType(tiles[currentTile]->getType());
-					tileDatabase[currentTile]->setItem(tiles[currentTile]->getItem());
-					tileDatabase[currentTile]->setWeight(tiles[currentTile]->getWeight());
-				}
-
-				// Stop sight if this tile is a shelf or wall or obstacle
-				if (tiles[currentTile]->getType() >= 2 && tiles[currentTile]->getType() <= 5 || tiles[currentTile]->getType() == 0 || tiles[currentTile]->getType() == 9) break;
-
-				// Stop sight if next tile is out of bounds
-				switch (dir) {
-				case 0: // Up
-					if (currentTile - map_width < 0) stop = true;
-					else if (tiles[currentTile - map_width] == nullptr) stop = true;
-
-					// Go to next tile
-					else currentTile -= map_width;
-
-					break;
-				case 1: // Down
-					if (currentTile + map_width >= map_width * map_height) stop = true;
-					else if (tiles[currentTile + map_width] == nullptr) stop = true;
-
-					// Go to next tile
-					else currentTile += map_width;
-
-					break;
-				case 2: // Left
-					if (currentTile % map_width == 0) stop = true;
-					else if (tiles[currentTile - 1] == nullptr) stop = true;
-
-					// Go to next tile
-					else currentTile--;
-
-					break;
-				case 3: // Right
-					if (currentTile % map_width == map_width - 1) stop = true;
-					else if (tiles[currentTile + 1] == nullptr) stop = true;
-
-					// Go to next tile
-					else currentTile++;
-
-					break;
-				}
-			}
-		}
+		// Set weight bar size
+		SDL_FRect weightBar = { hitbox.x - camera.x, hitbox.y - 5 - camera.y, WH * (float)robot->getWeight() / (float)MAX_WEIGHT, 4 };
+		weightBar.x *= SCREEN_SCALE;
+		weightBar.y *= SCREEN_SCALE;
+		weightBar.w *= SCREEN_SCALE;
+		weightBar.h *= SCREEN_SCALE;
+		// Render weight bar
+		SDL_SetRenderDrawColor(renderer, 0x46, 0xa2, 0xFF, 0xFF);
+		SDL_RenderFillRectF(renderer, &weightBar);
 	}
-	void updateHistory(Tile* tiles[]) {
-		int currentTile = getTile(tiles);
+}
 
-		if (tiles[currentTile] != nullptr) visitHistory[currentTile]++;
-	}
-	void resetHistory() {
-		for (int i = 0; i < MAX_TILES; i++) {
-			visitHistory[i] = 0;
-		}
-	}
-private:
-	SDL_FRect hitbox;
-	SDL_FRect weightBar;
-	float battery;
-	int sprite;
-	int dir; // 0: up, 1: down, 2: left, 3: right
-	int items[MAX_WEIGHT]; // the items being held by the robot
-	int weight; // the current weight of items that the robot is carrying
-	int visitHistory[MAX_TILES]; // How many times it has visited this tile
-};
+// Renders the tick timings and counters in the top left corner
+void renderProfile(const TickProfiler& profiler) {
+	float y = 10;
+	float lineHeight = (float)FONT_SIZE * (float)1.1;
+
+	textObj.str("");
+	textObj << "Ticks per second: " << (int)profiler.getTicksPerSecond();
+	renderText(textObj.str(), 10, y, false, true);
+	y += lineHeight;
+
+	// Percentiles of the time taken by each tick and each phase, in milliseconds
+	textObj.str("");
+	textObj.precision(3);
+	textObj << std::fixed << "Tick: p50 " << profiler.getTickTimes().percentile(0.5) / 1e6 << " p99 " << profiler.getTickTimes().percentile(0.99) / 1e6 << " max " << profiler.getTickTimes().getMax() / 1e6 << " ms";
+	renderText(textObj.str(), 10, y, false, true);
+	y += lineHeight;
+	for (int i = 0; i < NUMBER_OF_PHASES; i++) {
+		const LatencyHistogram& times = profiler.getPhaseTimes(i);
+		if (times.getCount() == 0) continue;
+
+		textObj.str("");
+		textObj << phaseName(i) << ": p50 " << times.percentile(0.5) / 1e6 << " p99 " << times.percentile(0.99) / 1e6 << " max " << times.getMax() / 1e6 << " ms";
+		renderText(textObj.str(), 10, y, false, true);
+		y += lineHeight;
+	}
+
+	// Average number of operations per tick
+	textObj.str("");
+	textObj.precision(1);
+	for (int i = 0; i < NUMBER_OF_COUNTERS; i++) {
+		if (i > 0) textObj << ", ";
+		textObj << counterName(i) << " " << (profiler.getTicks() > 0 ? (double)profiler.getCounter(i) / (double)profiler.getTicks() : 0);
+	}
+	textObj << " per tick";
+	renderText(textObj.str(), 10, y, false, true);
+
+	// Reset the stream's number format for other text
+	textObj.unsetf(std::ios::fixed);
+	textObj.precision(6);
+}
 
 // Button class
 class Button {
@@ -1122,9 +446,6 @@ public:
 			buttonTexture.render((float)hitbox.x, (float)hitbox.y, &buttonTextureClips[sprite], 1, 0, nullptr, SDL_FLIP_NONE, buttonColour);
 
 			if (text != "") {
-				// Load text to get its dimensions
-				textTexture.loadText(text, pixellari_medium);
-
 				// Render button text in the center of the button
 				renderTextMedium(text, (float)hitbox.x + (float)hitbox.w / 2, (float)hitbox.y + (float)hitbox.h / 2, true, true);
 			}
@@ -1207,6 +528,12 @@ bool loadFonts() {
 		printf("TTF_OpenFont error for Pixellari");
 		success = false;
 	}
+	if (!success) return false;
+
+	// Rasterise the characters of each font once
+	if (!textAtlas.load(pixellari)) success = false;
+	if (!textMediumAtlas.load(pixellari_medium)) success = false;
+	if (!titleAtlas.load(pixellari_title)) success = false;
 	return success;
 }
 
@@ -1215,7 +542,9 @@ void closeSDL() {
 	// Free textures
 	tilesTexture.freeTexture();
 	robotTexture.freeTexture();
-	textTexture.freeTexture();
+	textAtlas.freeTexture();
+	textMediumAtlas.freeTexture();
+	titleAtlas.freeTexture();
 	buttonTexture.freeTexture();
 
 	// Deallocate font
@@ -1233,127 +562,37 @@ void closeSDL() {
 	SDL_Quit();
 }
 
-// Converts a map file into an array of tiles
-int setTiles(Tile* tiles[], Tile* tileDatabase[], std::string mapFile, int mapWidth, int mapHeight) {
-	bool success = true;
-	float x = 0, y = 0;
-	MAP_WIDTH = mapWidth;
-	MAP_HEIGHT = mapHeight;
-	int numberOfShelves = 0;
-
-	// Load map file
-	std::ifstream map(mapFile.c_str());
-	if (map.fail()) {
-		printf("ifstream error: Could not load map file\n");
-		success = false;
-	}
-	else {
-		int tileType = -1;
-		for (int i = 0; i < mapWidth / WH * mapHeight / WH; i++) {
-			// Read tile type
-			map >> tileType;
-			if (map.fail()) {
-				printf("Unexpected end of file after tile %d\n", i);
-				success = false;
-				break;
-			}
-
-			// Create tiles
-			if ((tileType >= 0) && (tileType <= TILE_SPRITES)) {
-				// Set the first 10 shelves to have items 1 to 10. Remaining shelves have random items.
-				if (tileType >= 2 && tileType <= 5) {
-					tiles[i] = new Tile(x, y, tileType, numberOfShelves + 1, weightOf(numberOfShelves + 1));
-					//else tiles[i] = new Tile(x, y, tileType, rand() weightOf());
-
-					numberOfShelves++;
-				}
-				else tiles[i] = new Tile(x, y, tileType);
-
-				// Create tile in tileDatabase
-				tileDatabase[i] = new Tile(x, y);
-			}
-			else {
-				printf("Invalid tile type at %d\n", i);
-				success = false;
-				break;
-			}
-
-			// Go to next tile
-			x += WH;
-
-			if (x >= mapWidth) {
-				// Go to next row
-				x = 0;
-				y += WH;
-			}
-		}
-		map.close();
-	}
-	if (success) return numberOfShelves;
-	else return false;
-}
-
 // Just a function declaration
-int simulation(bool saveResults, int iteration);
+void simulation();
+void runTests(const std::vector<TestSetting>& testSettings, const std::string& journalPath);
+int replay(const std::string& path);
 
 // Initialise buttons
 Button* buttons[MAX_BUTTONS] = { nullptr };
 
-// Performance metrics
-int successfulRuns = 0;
-int failedRuns = 0;
-int ticksTaken[TEST_ITERATIONS] = { 0 };
-float ticksTakenPerItem[TEST_ITERATIONS] = { (float)0 };
-int numberDeadRobots[TEST_ITERATIONS] = { 0 };
-float timeTaken[TEST_ITERATIONS] = { (float)0 };
-
-void resetMetrics() {
-	successfulRuns = 0;
-	failedRuns = 0;
-
-	for (int i = 0; i < TEST_ITERATIONS; i++) {
-		ticksTaken[i] = 0;
-		ticksTakenPerItem[i] = (float)0;
-		numberDeadRobots[i] = 0;
-		timeTaken[i] = (float)0;
-	}
+// Settings of a simulation for the chosen map, robots and obstacles
+SimSettings currentSettings() {
+	SimSettings settings;
+	settings.mapNumber = mapNumber;
+	settings.mapPath = mapPath;
+	settings.mapWidth = MAP_WIDTH;
+	settings.mapHeight = MAP_HEIGHT;
+	settings.numberRobots = NUMBER_ROBOTS;
+	settings.numberObstacles = NUMBER_OBSTACLES;
+	return settings;
 }
 
-int runSimulation(int robots, int obstacles, std::ofstream& resultsFile) {
-	resetMetrics();
-	NUMBER_ROBOTS = robots;
-	NUMBER_OBSTACLES = obstacles;
-
-	int decide = 1;
-	for (int j = 0; j < TEST_ITERATIONS && decide == 1; j++) decide = simulation(true, j);
-
-	// Calculate average metrics
-	float averageTicksTaken = (float)0;
-	for (int m = 0; m < TEST_ITERATIONS; m++) averageTicksTaken += (float)ticksTaken[m];
-	averageTicksTaken /= (float)successfulRuns;
-
-	float averageTicksTakenPerItem = (float)0;
-	for (int m = 0; m < TEST_ITERATIONS; m++) averageTicksTakenPerItem += ticksTakenPerItem[m];
-	averageTicksTakenPerItem /= (float)successfulRuns;
-
-	float averageDeadRobots = (float)0;
-	for (int m = 0; m < TEST_ITERATIONS; m++) averageDeadRobots += (float)numberDeadRobots[m];
-	averageDeadRobots /= (float)successfulRuns;
-
-	float averageTimeTaken = (float)0;
-	for (int m = 0; m < TEST_ITERATIONS; m++) averageTimeTaken += timeTaken[m];
-	averageTimeTaken /= (float)successfulRuns;
-
-	resultsFile << "(Map: " << mapNumber << ", Robots: " << NUMBER_ROBOTS << ", Obstacles: " << NUMBER_OBSTACLES << ")\n";
-	resultsFile << "Successful Runs: " << successfulRuns << "\n";
-	resultsFile << "Failed Runs: " << failedRuns << "\n";
-	resultsFile << "Average Ticks Taken: " << averageTicksTaken << "\n";
-	resultsFile << "Average Ticks Taken Per Item: " << averageTicksTakenPerItem << "\n";
-	resultsFile << "Average Dead Robots: " << averageDeadRobots << "\n";
-	resultsFile << "Average Time Taken (seconds): " << averageTimeTaken << "\n";
-	resultsFile << "--------------------------------------------\n";
-
-	return decide;
+// Selects a map and its size
+void setMap(int number) {
+	mapNumber = number;
+	int width = 0;
+	int height = 0;
+	if (mapSizeOf(mapNumber, width, height)) {
+		MAP_WIDTH = width * WH;
+		MAP_HEIGHT = height * WH;
+	}
+
+	mapPath = mapPathOf(mapNumber);
 }
 
 // Main menu
@@ -1373,10 +612,12 @@ void menu() {
 	buttons[5] = new Button(SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2 + 50, "Change"); // Change number of robots
 	buttons[6] = new Button(3 * SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2 + 50, "Change"); // Change number of obstacles
 	buttons[7] = new Button(3 * SCREEN_WIDTH / 4, SCREEN_HEIGHT / 2 - 170, "Change"); // Change tick speed
+	buttons[10] = new Button(SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 + 270, "Change"); // Change test iterations
 	// Hide settings buttons initially
 	for (int i = 3; i <= 7; i++) {
 		if (buttons[i] != nullptr) buttons[i]->setShown();
 	}
+	buttons[10]->setShown();
 	
 	bool quit = false;
 	bool startSimulation = false;
@@ -1384,11 +625,13 @@ void menu() {
 	bool testAll = false;
 	bool startTraining = false;
 	bool changeSettings = false;
+	std::string replayPath;
 
 	// Main loop
 	while (!quit) {
-		// Handle events
-		while (SDL_PollEvent(&e) != 0) {
+		// Handle events, waiting for one first so an idle menu is not drawn again and again
+		bool hasEvent = SDL_WaitEventTimeout(&e, MENU_IDLE_INTERVAL) != 0;
+		while (hasEvent) {
 			// The close button
 			if (e.type == SDL_QUIT) quit = true;
 
@@ -1398,6 +641,17 @@ void menu() {
 				startSimulation = true;
 			}
 
+			// Replay the last simulation by pressing R, or a trace file dropped onto the window
+			if (e.type == SDL_KEYDOWN && e.key.repeat == 0 && e.key.keysym.sym == SDLK_r && !changeSettings) {
+				quit = true;
+				replayPath = LAST_TRACE_PATH;
+			}
+			if (e.type == SDL_DROPFILE) {
+				quit = true;
+				replayPath = e.drop.file;
+				SDL_free(e.drop.file);
+			}
+
 			// Settings button and Back button
 			if (buttons[1]->isShown() && buttons[1]->handleEvents(e) || buttons[3]->isShown() && buttons[3]->handleEvents(e)) {
 				changeSettings = !changeSettings;
@@ -1414,44 +668,7 @@ void menu() {
 				mapNumber++;
 				if (mapNumber > 8) mapNumber = 1;
 
-				switch (mapNumber) {
-				case 1:
-					MAP_WIDTH = 50 * WH;
-					MAP_HEIGHT = 50 * WH;
-					break;
-				case 2:
-					MAP_WIDTH = 50 * WH;
-					MAP_HEIGHT = 50 * WH;
-					break;
-				case 3:
-					MAP_WIDTH = 50 * WH;
-					MAP_HEIGHT = 50 * WH;
-					break;
-				case 4:
-					MAP_WIDTH = 25 * WH;
-					MAP_HEIGHT = 25 * WH;
-					break;
-				case 5:
-					MAP_WIDTH = 25 * WH;
-					MAP_HEIGHT = 25 * WH;
-					break;
-				case 6:
-					MAP_WIDTH = 100 * WH;
-					MAP_HEIGHT = 100 * WH;
-					break;
-				case 7:
-					MAP_WIDTH = 100 * WH;
-					MAP_HEIGHT = 100 * WH;
-					break;
-				case 8:
-					MAP_WIDTH = 100 * WH;
-					MAP_HEIGHT = 100 * WH;
-					break;
-				}
-
-				textObj.str("");
-				textObj << "warehouse_resources/map" << mapNumber << ".map";
-				mapPath = textObj.str().c_str();
+				setMap(mapNumber);
 			}
 
 			// Change number of robots
@@ -1478,6 +695,9 @@ void menu() {
 				if (TICK_INTERVAL > MAX_TICK_INTERVAL) TICK_INTERVAL = 0;
 			}
 
+			// Change test iterations
+			if (buttons[10]->isShown() && buttons[10]->handleEvents(e)) ADAPTIVE_TESTS = !ADAPTIVE_TESTS;
+
 			// Test All
 			if (buttons[8]->isShown() && buttons[8]->handleEvents(e)) {
 				quit = true;
@@ -1489,6 +709,8 @@ void menu() {
 				quit = true;
 				test = true;
 			}
+
+			hasEvent = SDL_PollEvent(&e) != 0;
 		}
 
 		// Reset screen
@@ -1496,7 +718,10 @@ void menu() {
 		SDL_RenderClear(renderer);
 
 		// Render text
-		if (!changeSettings) renderTitle("Warehouse Robot Simulation", (float)SCREEN_WIDTH / 2, 300, true);
+		if (!changeSettings) {
+			renderTitle("Warehouse Robot Simulation", (float)SCREEN_WIDTH / 2, 300, true);
+			renderText("Press R to replay the last simulation, or drop a trace file here to replay it", (float)SCREEN_WIDTH / 2, (float)SCREEN_HEIGHT - 40, true);
+		}
 		else {
 			renderTitle("Settings", (float)SCREEN_WIDTH / 2, 150, true);
 
@@ -1515,6 +740,11 @@ void menu() {
 			textObj.str("");
 			textObj << "Number of Obstacles: " << NUMBER_OBSTACLES;
 			renderTitle(textObj.str().c_str(), (float)3 * SCREEN_WIDTH / 4, (float)SCREEN_HEIGHT / 2 - 60, true);
+
+			textObj.str("");
+			if (ADAPTIVE_TESTS) textObj << "Test Iterations: " << MIN_TEST_ITERATIONS << " to " << MAX_TEST_ITERATIONS << " (adaptive)";
+			else textObj << "Test Iterations: " << TEST_ITERATIONS;
+			renderTitle(textObj.str().c_str(), (float)SCREEN_WIDTH / 2, (float)SCREEN_HEIGHT / 2 + 160, true);
 		}
 
 		// Render buttons
@@ -1536,150 +766,145 @@ void menu() {
 	}
 
 	// Run simulation for the chosen settings
-	if (startSimulation) simulation(false, 0);
+	if (startSimulation) simulation();
+	// Replay a recorded simulation
+	else if (!replayPath.empty()) replay(replayPath);
 	// Test logical settings
-	else if (test) {
-		// Create a file
-		std::ofstream resultsFile("simulation test results.txt");
-
-		int decide = 1;
-		for (int i = 1; i <= 8 && decide != 0; i++) {
-			mapNumber = i;
-
-			switch (mapNumber) {
-			case 1:
-				MAP_WIDTH = 50 * WH;
-				MAP_HEIGHT = 50 * WH;
-				break;
-			case 2:
-				MAP_WIDTH = 50 * WH;
-				MAP_HEIGHT = 50 * WH;
-				break;
-			case 3:
-				MAP_WIDTH = 50 * WH;
-				MAP_HEIGHT = 50 * WH;
-				break;
-			case 4:
-				MAP_WIDTH = 25 * WH;
-				MAP_HEIGHT = 25 * WH;
-				break;
-			case 5:
-				MAP_WIDTH = 25 * WH;
-				MAP_HEIGHT = 25 * WH;
-				break;
-			case 6:
-				MAP_WIDTH = 100 * WH;
-				MAP_HEIGHT = 100 * WH;
-				break;
-			case 7:
-				MAP_WIDTH = 100 * WH;
-				MAP_HEIGHT = 100 * WH;
-				break;
-			case 8:
-				MAP_WIDTH = 100 * WH;
-				MAP_HEIGHT = 100 * WH;
-				break;
-			}
+	else if (test) runTests(logicalTestSettings(), "simulation test journal.txt");
+	// Test all combinations of settings
+	else if (testAll) runTests(allTestSettings(), "simulation test all journal.txt");
+}
 
-			textObj.str("");
-			textObj << "warehouse_resources/map" << mapNumber << ".map";
-			mapPath = textObj.str().c_str();
-
-			switch (MAP_WIDTH) {
-			case 25 * WH:
-				if (decide != 0) decide = runSimulation(10, 15, resultsFile);
-				if (decide != 0) decide = runSimulation(20, 10, resultsFile);
-				if (decide != 0) decide = runSimulation(20, 5, resultsFile);
-				break;
-			case 50 * WH:
-				if (decide != 0) decide = runSimulation(15, 25, resultsFile);
-				if (decide != 0) decide = runSimulation(30, 15, resultsFile);
-				if (decide != 0) decide = runSimulation(50, 5, resultsFile);
-				break;
-			case 100 * WH:
-				if (decide != 0) decide = runSimulation(50, 100, resultsFile);
-				if (decide != 0) decide = runSimulation(100, 50, resultsFile);
-				if (decide != 0) decide = runSimulation(100, 100, resultsFile);
-				break;
+// Runs "Test" or "Test All" on every CPU core without rendering, showing its progress until it finishes or is stopped
+void runTests(const std::vector<TestSetting>& testSettings, const std::string& journalPath) {
+	std::vector<SimSettings> settings;
+	for (const TestSetting& setting : testSettings) {
+		settings.push_back(testSettingsFor(setting));
+		// Tick timings for the results file and throughput for the record of every run
+		settings.back().profile = true;
+		settings.back().recordThroughput = true;
+	}
+	int iterations = ADAPTIVE_TESTS ? MIN_TEST_ITERATIONS : TEST_ITERATIONS;
+
+	SweepRunner runner(0);
+	if (ADAPTIVE_TESTS) runner.setAdaptive(MAX_TEST_ITERATIONS, TEST_PRECISION);
+
+	// Carry on from an interrupted sweep, with the seed it was started with
+	SweepJournal journal;
+	uint64_t sweepSeed = (uint64_t)time(0);
+	std::string options = runner.getOptions(iterations);
+	bool journalOpen = journal.open(journalPath, sweepSeed, options);
+	// A test stopped with the other "Test Iterations" setting starts again from the beginning
+	if (!journalOpen && journal.getOptions() != options) {
+		printf("%s belongs to a test with other test iterations; starting a new test\n", journalPath.c_str());
+		remove(journalPath.c_str());
+		journalOpen = journal.open(journalPath, sweepSeed, options);
+	}
+	if (journalOpen) {
+		sweepSeed = journal.getSweepSeed();
+		runner.setJournal(&journal);
+	}
+	if (journal.getResumedRuns() > 0) printf("Resuming from %s: %d runs already finished\n", journalPath.c_str(), journal.getResumedRuns());
+
+	// Create a file
+	std::ofstream resultsFile("simulation test results.txt");
+	writeResultsHeader(resultsFile, sweepSeed);
+	RunLog runLog;
+	runLog.open("simulation test runs.jsonl");
+	printf("Testing %d combinations of settings on %d threads\n", (int)settings.size(), runner.getThreads());
+	printf("Seed: %llu\n\n", (unsigned long long)sweepSeed);
+
+	// Progress of the sweep, updated by the threads running it
+	std::atomic<int> settingsDone(0);
+	std::atomic<int> runsDone(0);
+	std::atomic<bool> sweepDone(false);
+	std::mutex progressMutex;
+	std::string lastSetting;
+
+	std::thread sweep([&]() {
+		runner.run(settings, iterations, sweepSeed, [&](int setting, const std::vector<RunResult>& runs, const std::string& stopReason) {
+			writeResults(resultsFile, settings[setting], runs, stopReason);
+			resultsFile.flush();
+
+			int successfulRuns = 0;
+			for (const RunResult& run : runs) {
+				if (run.completed) successfulRuns++;
 			}
-		}
-		resultsFile.close();
-	}
-	// Test all combinations of settings
-	else if (testAll) {
-		int decide = 1;
-
-		// Create a file
-		std::ofstream resultsFile("simulation test results.txt");
-
-		// i is the map number
-		for (int i = 1; i <= 8 && decide != 0; i++) {
-			mapNumber = i;
-
-			switch (mapNumber) {
-			case 1:
-				MAP_WIDTH = 50 * WH;
-				MAP_HEIGHT = 50 * WH;
-				break;
-			case 2:
-				MAP_WIDTH = 50 * WH;
-				MAP_HEIGHT = 50 * WH;
-				break;
-			case 3:
-				MAP_WIDTH = 50 * WH;
-				MAP_HEIGHT = 50 * WH;
-				break;
-			case 4:
-				MAP_WIDTH = 25 * WH;
-				MAP_HEIGHT = 25 * WH;
-				break;
-			case 5:
-				MAP_WIDTH = 25 * WH;
-				MAP_HEIGHT = 25 * WH;
-				break;
-			case 6:
-				MAP_WIDTH = 100 * WH;
-				MAP_HEIGHT = 100 * WH;
-				break;
-			case 7:
-				MAP_WIDTH = 100 * WH;
-				MAP_HEIGHT = 100 * WH;
-				break;
-			case 8:
-				MAP_WIDTH = 100 * WH;
-				MAP_HEIGHT = 100 * WH;
-				break;
+			std::ostringstream line;
+			line << "Map " << settings[setting].mapNumber << ", " << settings[setting].numberRobots << " robots, " << settings[setting].numberObstacles << " obstacles: " << successfulRuns << "/" << runs.size() << " successful runs";
+			if (!stopReason.empty()) line << " (" << stopReason << ")";
+			printf("[%d/%d] %s\n", setting + 1, (int)settings.size(), line.str().c_str());
+			fflush(stdout);
+
+			std::lock_guard<std::mutex> lock(progressMutex);
+			lastSetting = line.str();
+			settingsDone++;
+		}, [&](int setting, int iteration, const RunResult& run) {
+			runLog.add(settings[setting], iteration, run);
+			runsDone++;
+		});
+		sweepDone = true;
+	});
+
+	bool stopped = false;
+	bool quit = false;
+	SDL_Event e;
+	while (!sweepDone) {
+		// Handle events, drawing the progress again a few times a second
+		bool hasEvent = SDL_WaitEventTimeout(&e, TEST_PROGRESS_INTERVAL) != 0;
+		while (hasEvent) {
+			// Stop by closing the window or pressing ESC; the runs in progress still finish and are kept in the journal
+			if (e.type == SDL_QUIT || (e.type == SDL_KEYDOWN && e.key.repeat == 0 && e.key.keysym.sym == SDLK_ESCAPE)) {
+				if (e.type == SDL_QUIT) quit = true;
+				stopped = true;
+				runner.stop();
 			}
+			hasEvent = SDL_PollEvent(&e) != 0;
+		}
 
-			textObj.str("");
-			textObj << "warehouse_resources/map" << mapNumber << ".map";
-			mapPath = textObj.str().c_str();
+		// Reset screen
+		SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0xFF);
+		SDL_RenderClear(renderer);
 
-			// j is the number of robots
-			for (int j = 1; j <= 100 && decide != 0; j += 10) {
-				if (j == 11) j--;
-				if (j > 1 && j <= 35) j -= 5;
+		// Render progress
+		renderTitle(stopped ? "Stopping" : "Testing", (float)SCREEN_WIDTH / 2, 150, true);
 
-				// k is the number of obstacles
-				for (int k = 0; k <= 100 && decide != 0; k += 10) {
-					if (k > 0 && k <= 35) k -= 5;
+		textObj.str("");
+		textObj << "Combinations of settings finished: " << settingsDone << " of " << settings.size();
+		renderTextMedium(textObj.str(), (float)SCREEN_WIDTH / 2, (float)SCREEN_HEIGHT / 2 - 100, true);
 
-					decide = runSimulation(j, k, resultsFile);
-				}
-			}
+		textObj.str("");
+		textObj << "Simulations run: " << runsDone;
+		if (!ADAPTIVE_TESTS) textObj << " of " << (int)settings.size() * iterations - journal.getResumedRuns();
+		textObj << " on " << runner.getThreads() << " threads";
+		renderTextMedium(textObj.str(), (float)SCREEN_WIDTH / 2, (float)SCREEN_HEIGHT / 2, true);
+
+		{
+			std::lock_guard<std::mutex> lock(progressMutex);
+			if (!lastSetting.empty()) renderTextMedium(lastSetting, (float)SCREEN_WIDTH / 2, (float)SCREEN_HEIGHT / 2 + 100, true);
 		}
 
-		resultsFile.close();
+		if (stopped) renderText("Waiting for the simulations in progress to finish", (float)SCREEN_WIDTH / 2, (float)SCREEN_HEIGHT - 40, true);
+		else renderText("Press ESC to stop; starting the same test again carries on where it stopped", (float)SCREEN_WIDTH / 2, (float)SCREEN_HEIGHT - 40, true);
+
+		// Update the screen
+		SDL_RenderPresent(renderer);
 	}
-}
+	sweep.join();
 
-// Initialise objects
-Tile* tiles[MAX_TILES] = { nullptr };
-Tile* tileDatabase[MAX_TILES] = { nullptr };
-Robot* robots[MAX_ROBOTS] = { nullptr };
+	resultsFile.close();
+	runLog.close();
+	journal.close();
+	printf("\n%d simulations run\n", (int)runsDone);
+	printf("-------------------------------------------\n");
+	// Start the next sweep afresh once this one has finished
+	if (!stopped) remove(journalPath.c_str());
+
+	if (!quit) menu();
+}
 
 // Main simulation code
-int simulation(bool saveResults, int iteration) {
+void simulation() {
 	// Initialise variables
 	SDL_FRect camera = { 0, 0, (float)SCREEN_WIDTH / SCREEN_SCALE, (float)SCREEN_HEIGHT / SCREEN_SCALE };
 	float camSpd = 10;
@@ -1702,82 +927,47 @@ int simulation(bool saveResults, int iteration) {
 		if (buttons[i] != nullptr) buttons[i]->setShown();
 	}
 
-	if (saveResults) buttons[2]->disable();
-
-	// Random seed
-	srand((unsigned int)time(0));
-
-	int itemList[MAX_ITEMS_RETRIEVE] = { 0 };
-	int predItemList[MAX_ITEMS_RETRIEVE] = { 0 };
-	int numberOfShelves = 0;
+	// Simulation engine, seeded randomly
+	SimSettings settings = currentSettings();
+	// Tick timings for the profile overlay
+	settings.profile = true;
+	// Record the simulation so it can be replayed from the menu
+	settings.recordTrace = true;
+	uint64_t seed = (uint64_t)time(0);
+	WarehouseSim* sim = new WarehouseSim(settings, seed);
 
 	// Event flag
 	bool returnMenu = false;
 	bool finishSimulation = false;
-	bool skip = false;
-
-	// Create tiles based on map
-	numberOfShelves = setTiles(tiles, tileDatabase, mapPath, MAP_WIDTH, MAP_HEIGHT);
-	if (numberOfShelves == 0) printf("setTiles() error\n");
-	else {
-		// in tileDatabase, set all black tiles (type 0)
-		for (int i = 0; i < MAX_TILES; i++) {
-			if (tiles[i] != nullptr) {
-				if (tiles[i]->getType() == 0) tileDatabase[i]->setTileType(tiles[i]->getType());
-			}
-		}
 
+	// Create tiles based on map; loadMap() prints the error if it fails
+	if (sim->loadMap()) {
 		// Create robots in random valid locations
-		for (int i = 0; i < NUMBER_ROBOTS; i++) {
-			int spawnX = 0;
-			int spawnY = 0;
-
-			bool valid = false;
-			while (!valid) {
-				spawnX = WH * (rand() % MAP_WIDTH / WH);
-				spawnY = WH * (rand() % MAP_HEIGHT / WH);
-
-				for (int j = 0; j < MAX_TILES; j++) {
-					if (tiles[j] != nullptr) {
-						if (tiles[j]->getX() == spawnX && tiles[j]->getY() == spawnY) {
-							if (tiles[j]->getType() == 1 || tiles[j]->getType() >= 6 && tiles[j]->getType() <= 8) {
-								valid = true;
-								break;
-							}
-						}
-					}
-				}
-			}
-			robots[i] = new Robot((float)spawnX, (float)spawnY);
-		}
+		sim->spawnRobots();
 
 		// List of items to retrieve
-		for (int i = 0; i < NUMBER_ITEMS_RETRIEVE; i++) {
-			itemList[i] = rand() % numberOfShelves + 1;
-			predItemList[i] = itemList[i];
-		}
+		sim->createItemList();
 
 		// Time control
 		Uint64 lastTick = 0;
 
-		bool receivingItem[MAX_ROBOTS] = { false };
-		bool chargerKnown = false;
-		int deadRobot[MAX_ROBOTS] = { -1 }; // index is the dead robot, value is the robot to rescue it
-		float currentGoal[MAX_ROBOTS] = { -1 }; // 0: explore, 1: shelf, 2: charger, 3: exit, 4: dead robot
-
 		// Print settings
-		printf("Running simulation %d for:\n", iteration + 1);
+		printf("Running simulation for:\n");
 		printf("> Map %d\n", mapNumber);
 		if (NUMBER_ROBOTS == 1) printf("> %d robot\n", NUMBER_ROBOTS);
 		else printf("> %d robots\n", NUMBER_ROBOTS);
-		printf("> %d obstacles\n\n", NUMBER_OBSTACLES);
+		printf("> %d obstacles\n", NUMBER_OBSTACLES);
+		printf("> Seed %llu\n\n", (unsigned long long)seed);
 
 		bool quit = false;
 		bool pause = false;
 		bool view = false; // false: real layout, true: robots' knowledge of the layout
+		bool showProfile = false; // Show tick timings over the simulation
 
 		// Main loop
 		while (!quit) {
+			uint64_t frameStart = sim->getProfiler().now();
+
 			// Handle events
 			while (SDL_PollEvent(&e) != 0) {
 				// The close button
@@ -1824,7 +1014,8 @@ int simulation(bool saveResults, int iteration) {
 						break;
 						// Switch between real layout and robots' knowledge of the layout
 					case SDLK_TAB: if (!pause) view = !view; break;
-					case SDLK_SPACE: if (!pause) skip = true; break;
+						// Show or hide tick timings
+					case SDLK_p: showProfile = !showProfile; break;
 					}
 				}
 
@@ -1854,7 +1045,7 @@ int simulation(bool saveResults, int iteration) {
 				// Quit button
 				if (buttons[3]->isShown() && buttons[3]->handleEvents(e)) {
 					quit = true;
-					return 0;
+					return;
 				}
 
 				// Menu button
@@ -1863,540 +1054,20 @@ int simulation(bool saveResults, int iteration) {
 					returnMenu = true;
 				}
 			}
+			sim->getProfiler().recordFrame(PHASE_EVENTS, frameStart);
 
 			if (!pause) {
-				// Obstacle tile generation and deletion at fixed tick intervals
-				if (ticks % OBSTACLE_CD == 0) {
-					// Reset all existing obstacle tiles to be floor tiles
-					for (int i = 0; i < MAX_TILES; i++) {
-						if (tiles[i] != nullptr) {
-							if (tiles[i]->getType() == 9) tiles[i]->setTileType(1);
-						}
-					}
-
-					// Randomly generate obstacle tiles
-					for (int i = 0; i < NUMBER_OBSTACLES; i++) {
-						// Look for a random floor tile (type == 1)
-						bool valid = false;
-						while (!valid) {
-							int obstacleTile = rand() % MAX_TILES;
-
-							if (tiles[obstacleTile] != nullptr) {
-								if (tiles[obstacleTile]->getType() == 1) {
-									valid = true;
-
-									// Check that there are no robots on this tile
-									for (int j = 0; j < NUMBER_ROBOTS; j++) {
-										if (robots[j]->getBox().x == tiles[obstacleTile]->getX() && robots[j]->getBox().y == tiles[obstacleTile]->getY()) {
-											valid = false;
-											break;
-										}
-									}
-								}
-
-								if (valid) tiles[obstacleTile]->setTileType(9);
-							}
-						}
-					}
-				}
-
 				// Process robots
 				if (SDL_GetTicks64() - lastTick > TICK_INTERVAL) {
-					ticks++;
-
-					// The entire decision and pathfinding algorithm is in this for-loop
-					for (int i = 0; i < MAX_ROBOTS && !quit; i++) {
-						if (robots[i] != nullptr) {
-							if (robots[i]->getBattery() > 0) {
-								float goalX = robots[i]->getBox().x;
-								float goalY = robots[i]->getBox().y;
-								double distance = std::numeric_limits<double>::infinity();
-								int takeDir = -1;
-								bool findShelf = false;
-								bool explore = false;
-								bool findExit = false;
-								bool takeItemFromShelf = false;
-								bool findCharger = false;
-								bool waitingForCharger = false;
-								bool chargeBattery = false;
-								bool lookForNextCharger = false;
-								bool submit = false;
-								bool passItemAway = false;
-								int recipientRobot = 0;
-								int recipientSpace = 0;
-								int passDir = 0;
-
-								int rescueRobot = -1;
-								for (int j = 0; j < MAX_ROBOTS; j++) {
-									if (robots[j] != nullptr) {
-										if (deadRobot[j] == i) {
-											rescueRobot = j;
-											break;
-										}
-									}
-								}
-								bool takeRobotItems = false;
-
-								if (receivingItem[i]) {
-									receivingItem[i] = false;
-								}
-								else {
-									// Find smallest item in itemList
-									int smallestItem = MAX_WEIGHT;
-									for (int j = 0; j < NUMBER_ITEMS_RETRIEVE; j++) {
-										if (weightOf(predItemList[j]) < weightOf(smallestItem) && predItemList[j] > 0) {
-											smallestItem = predItemList[j];
-											if (weightOf(smallestItem) == 1) break;
-										}
-									}
-
-									// Charge until 100 if already charging
-									if (tileDatabase[robots[i]->getTile(tileDatabase)] != nullptr) {
-										if (tileDatabase[robots[i]->getTile(tileDatabase)]->getType() == 6 && robots[i]->getBattery() < 100) chargeBattery = true;
-									}
-									if (!chargeBattery) {
-										// If robot is low on battery
-										if (robots[i]->getBattery() < 50 || !chargerKnown) {
-											double saveDistance = 0.0;
-											// Look for the closest battery charger
-											for (int j = 0; j < MAX_TILES; j++) {
-												if (tileDatabase[j] != nullptr) {
-													if (tileDatabase[j]->getType() == 6) {
-														if (std::sqrt(pow(tileDatabase[j]->getX() - robots[i]->getBox().x, 2) + pow(tileDatabase[j]->getY() - robots[i]->getBox().y, 2)) < distance) {
-															goalX = tileDatabase[j]->getX();
-															goalY = tileDatabase[j]->getY();
-															distance = std::sqrt(pow(goalX - robots[i]->getBox().x, 2) + pow(goalY - robots[i]->getBox().y, 2));
-															findCharger = true;
-															chargerKnown = true;
-															lookForNextCharger = false;
-
-															// If standing on charger, charge
-															if (distance == 0) chargeBattery = true;
-															// Check if some other robot is already on that charger
-															else {
-																for (int k = 0; k < NUMBER_ROBOTS; k++) {
-																	if (robots[k] != nullptr) {
-																		if (robots[k]->getBox().x == goalX && robots[k]->getBox().y == goalY) {
-																			// Reset as if this charger is no longer a charger
-																			findCharger = false;
-																			lookForNextCharger = true;
-																			saveDistance = distance;
-																			distance = std::numeric_limits<double>::infinity();
-																			break;
-																		}
-																	}
-																}
-															}
-														}
-													}
-												}
-											}
-											
-											if (!findCharger) {
-												// Waiting for charger
-												if (lookForNextCharger && saveDistance > WH) {
-													waitingForCharger = true;
-													robots[i]->resetHistory();
-												}
-
-												// If no known chargers, explore to look for one
-												else explore = true;
-											}
-											else if (currentGoal[i] != 2) {
-												currentGoal[i] = 2;
-												robots[i]->resetHistory();
-											}
-										}
-										// If robot is assigned to rescue a dead robot and has no items in hand
-										else if (rescueRobot >= 0 && robots[i]->getWeight() == 0) {
-											goalX = robots[rescueRobot]->getBox().x;
-											goalY = robots[rescueRobot]->getBox().y;
-											
-											if (robots[i]->getBox().x == robots[rescueRobot]->getBox().x) {
-												// If above dead robot
-												if (robots[i]->getBox().y == robots[rescueRobot]->getBox().y - WH) {
-													takeRobotItems = true;
-													takeDir = 1;
-												}
-												// If below dead robot
-												else if (robots[i]->getBox().y == robots[rescueRobot]->getBox().y + WH) {
-													takeRobotItems = true;
-													takeDir = 0;
-												}
-											}
-											else if (robots[i]->getBox().y == robots[rescueRobot]->getBox().y) {
-												// If to the left of dead robot
-												if (robots[i]->getBox().x == robots[rescueRobot]->getBox().x - WH) {
-													takeRobotItems = true;
-													takeDir = 3;
-												}
-												// If to the right of dead robot
-												else if (robots[i]->getBox().x == robots[rescueRobot]->getBox().x + WH) {
-													takeRobotItems = true;
-													takeDir = 2;
-												}
-											}
-
-											if (currentGoal[i] != 4) {
-												currentGoal[i] = 4;
-												robots[i]->resetHistory();
-											}
-										}
-										// If robot still has space for an item
-										else if (robots[i]->getWeight() + weightOf(smallestItem) <= MAX_WEIGHT) {
-											// Look for the closest shelf with an item in predItemList
-											for (int j = 0; j < MAX_TILES; j++) {
-												if (tileDatabase[j] != nullptr) {
-													if (tileDatabase[j]->getType() >= 2 && tileDatabase[j]->getType() <= 5) {
-														for (int k = 0; k < NUMBER_ITEMS_RETRIEVE; k++) {
-															// If this item is in predItemList and the robot has space for it
-															if (tileDatabase[j]->getItem() == predItemList[k] && robots[i]->getWeight() + tileDatabase[j]->getWeight() <= MAX_WEIGHT) {
-																switch (tileDatabase[j]->getType()) {
-																case 2:
-																	if (std::sqrt(pow(tileDatabase[j]->getX() - robots[i]->getBox().x, 2) + pow(tileDatabase[j]->getY() - WH - robots[i]->getBox().y, 2)) < distance) {
-																		goalX = tileDatabase[j]->getX();
-																		goalY = tileDatabase[j]->getY() - WH;
-																		takeDir = 1;
-																	}
-																	break;
-																case 3:
-																	if (std::sqrt(pow(tileDatabase[j]->getX() - robots[i]->getBox().x, 2) + pow(tileDatabase[j]->getY() + WH - robots[i]->getBox().y, 2)) < distance) {
-																		goalX = tileDatabase[j]->getX();
-																		goalY = tileDatabase[j]->getY() + WH;
-																		takeDir = 0;
-																	}
-																	break;
-																case 4:
-																	if (std::sqrt(pow(tileDatabase[j]->getX() - WH - robots[i]->getBox().x, 2) + pow(tileDatabase[j]->getY() - robots[i]->getBox().y, 2)) < distance) {
-																		goalX = tileDatabase[j]->getX() - WH;
-																		goalY = tileDatabase[j]->getY();
-																		takeDir = 3;
-																	}
-																	break;
-																case 5:
-																	if (std::sqrt(pow(tileDatabase[j]->getX() + WH - robots[i]->getBox().x, 2) + pow(tileDatabase[j]->getY() - robots[i]->getBox().y, 2)) < distance) {
-																		goalX = tileDatabase[j]->getX() + WH;
-																		goalY = tileDatabase[j]->getY();
-																		takeDir = 2;
-																	}
-																	break;
-																}
-																distance = std::sqrt(pow(goalX - robots[i]->getBox().x, 2) + pow(goalY - robots[i]->getBox().y, 2));
-																findShelf = true;
-															}
-														}
-														if (distance == 0 && robots[i]->getWeight() + tileDatabase[j]->getWeight() <= MAX_WEIGHT && findShelf) {
-															takeItemFromShelf = true;
-															break;
-														}
-													}
-												}
-											}
-											// If no known shelf with an item in predItemList exists, explore
-											if (!findShelf) explore = true;
-											else if (currentGoal[i] != 1) {
-												currentGoal[i] = 1;
-												robots[i]->resetHistory();
-											}
-										}
-										else {
-											// Look for closest exit
-											for (int j = 0; j < MAX_TILES; j++) {
-												if (tileDatabase[j] != nullptr) {
-													if (tileDatabase[j]->getType() == 8) {
-														if (std::sqrt(pow(tileDatabase[j]->getX() - robots[i]->getBox().x, 2) + pow(tileDatabase[j]->getY() - robots[i]->getBox().y, 2)) < distance) {
-															goalX = tileDatabase[j]->getX();
-															goalY = tileDatabase[j]->getY();
-															distance = std::sqrt(pow(goalX - robots[i]->getBox().x, 2) + pow(goalY - robots[i]->getBox().y, 2));
-															findExit = true;
-
-															if (distance == 0 && robots[i]->getWeight() > 0) submit = true;
-														}
-													}
-												}
-											}
-											// If no known exit in database, explore
-											if (!findExit) explore = true;
-											else if (currentGoal[i] != 3) {
-												currentGoal[i] = 3;
-												robots[i]->resetHistory();
-											}
-										}
-									}
-								}
-								// Exploration
-								if (explore) {
-									// Look for the nearest unknown tile
-									for (int j = 0; j < MAX_TILES; j++) {
-										if (tileDatabase[j] != nullptr) {
-											if (tileDatabase[j]->getType() == -1) {
-												if (std::sqrt(pow(tiles[j]->getX() - robots[i]->getBox().x, 2) + pow(tiles[j]->getY() - robots[i]->getBox().y, 2)) < distance) {
-													goalX = tiles[j]->getX();
-													goalY = tiles[j]->getY();
-													distance = std::sqrt(pow(goalX - robots[i]->getBox().x, 2) + pow(goalY - robots[i]->getBox().y, 2));
-												}
-											}
-										}
-									}
-
-									if (currentGoal[i] != 0) {
-										currentGoal[i] = 0;
-										robots[i]->resetHistory();
-									}
-								}
-
-								// Calculate f(n) = g(n) + h(n)
-								double f[4] = { 0 };
-
-								// where g(n) = visit history
-								int currentTile = robots[i]->getTile(tileDatabase);
-								int historyWeight = 100;
-
-								f[0] += (double)(historyWeight * robots[i]->getHistory(currentTile - MAP_WIDTH / WH));
-								f[1] += (double)(historyWeight * robots[i]->getHistory(currentTile + MAP_WIDTH / WH));
-								f[2] += (double)(historyWeight * robots[i]->getHistory(currentTile - 1));
-								f[3] += (double)(historyWeight * robots[i]->getHistory(currentTile + 1));
-
-								// h(n) = Euclidean distance from goal
-								f[0] -= std::sqrt(pow(goalX - robots[i]->getBox().x, 2) + pow(goalY - robots[i]->getBox().y - WH, 2)); // Up
-								f[1] -= std::sqrt(pow(goalX - robots[i]->getBox().x, 2) + pow(goalY - robots[i]->getBox().y + WH, 2)); // Down
-								f[2] -= std::sqrt(pow(goalX - robots[i]->getBox().x - WH, 2) + pow(goalY - robots[i]->getBox().y, 2)); // Left
-								f[3] -= std::sqrt(pow(goalX - robots[i]->getBox().x + WH, 2) + pow(goalY - robots[i]->getBox().y, 2)); // Right
-
-								// Check that robot is not moving to a blocked tile
-								for (int j = 0; j < MAX_TILES; j++) {
-									if (tileDatabase[j] != nullptr) {
-										// Check if adjacent tile type is walkable tile type
-										if (tileDatabase[j]->getType() != -1 && tileDatabase[j]->getType() != 1 && (tileDatabase[j]->getType() < 6 || tileDatabase[j]->getType() > 8)) {
-											if (tileDatabase[j]->getX() == robots[i]->getBox().x) {
-												if (tileDatabase[j]->getY() == robots[i]->getBox().y - WH) f[0] = std::numeric_limits<double>::infinity();
-												else if (tileDatabase[j]->getY() == robots[i]->getBox().y + WH) f[1] = std::numeric_limits<double>::infinity();
-											}
-											else if (tileDatabase[j]->getY() == robots[i]->getBox().y) {
-												if (tileDatabase[j]->getX() == robots[i]->getBox().x - WH) f[2] = std::numeric_limits<double>::infinity();
-												else if (tileDatabase[j]->getX() == robots[i]->getBox().x + WH) f[3] = std::numeric_limits<double>::infinity();
-											}
-										}
-
-										// Check if robot is at the edge of the map
-										if (robots[i]->getBox().x == 0) f[2] = std::numeric_limits<double>::infinity();
-										if (robots[i]->getBox().x == MAP_WIDTH - WH) f[3] = std::numeric_limits<double>::infinity();
-										if (robots[i]->getBox().y == 0) f[0] = std::numeric_limits<double>::infinity();
-										if (robots[i]->getBox().y == MAP_HEIGHT - WH) f[1] = std::numeric_limits<double>::infinity();
-									}
-								}
-
-								// Choose minimum f(n)
-								int bestAction = 0;
-								for (int j = 1; j < 4; j++) {
-									if (f[j] < f[bestAction]) {
-										bestAction = j;
-									}
-								}
-
-								// Check that that movement is not blocked by a robot
-								// If blocked and finding exit, pass item to that robot
-								int itemToPass = 0;
-								for (int j = 0; j < NUMBER_ROBOTS; j++) {
-									if (robots[j] != nullptr) {
-										if (robots[j]->getBox().x == robots[i]->getBox().x) {
-											if (robots[j]->getBox().y == robots[i]->getBox().y - WH) {
-												f[0] = std::numeric_limits<double>::infinity();
-
-												if (robots[j]->getBattery() > 0 && findExit && bestAction == 0 && robots[j]->getWeight() < MAX_WEIGHT && std::sqrt(pow(goalX - robots[j]->getBox().x, 2) + pow(goalY - robots[j]->getBox().y, 2)) < std::sqrt(pow(goalX - robots[i]->getBox().x, 2) + pow(goalY - robots[i]->getBox().y, 2))) {
-													recipientSpace = MAX_WEIGHT - robots[recipientRobot]->getWeight();
-
-													// Find largest item that can be passed
-													for (int k = 0; k < MAX_WEIGHT; k++) {
-														if (weightOf(robots[i]->getItem(k)) > weightOf(itemToPass) && weightOf(robots[i]->getItem(k)) <= recipientSpace) itemToPass = robots[i]->getItem(k);
-													}
-
-													if (itemToPass > 0) {
-														passItemAway = true;
-														recipientRobot = j;
-														passDir = 0;
-														break;
-													}
-												}
-											}
-											else if (robots[j]->getBox().y == robots[i]->getBox().y + WH) {
-												f[1] = std::numeric_limits<double>::infinity();
-
-												if (robots[j]->getBattery() > 0 && findExit && bestAction == 1 && robots[j]->getWeight() < MAX_WEIGHT && std::sqrt(pow(goalX - robots[j]->getBox().x, 2) + pow(goalY - robots[j]->getBox().y, 2)) < std::sqrt(pow(goalX - robots[i]->getBox().x, 2) + pow(goalY - robots[i]->getBox().y, 2))) {
-													recipientSpace = MAX_WEIGHT - robots[recipientRobot]->getWeight();
-
-													// Find largest item that can be passed
-													for (int k = 0; k < MAX_WEIGHT; k++) {
-														if (weightOf(robots[i]->getItem(k)) > weightOf(itemToPass) && weightOf(robots[i]->getItem(k)) <= recipientSpace) itemToPass = robots[i]->getItem(k);
-													}
-
-													if (itemToPass > 0) {
-														passItemAway = true;
-														recipientRobot = j;
-														passDir = 1;
-														break;
-													}
-												}
-											}
-										}
-										else if (robots[j]->getBox().y == robots[i]->getBox().y) {
-											if (robots[j]->getBox().x == robots[i]->getBox().x - WH) {
-												f[2] = std::numeric_limits<double>::infinity();
-
-												if (robots[j]->getBattery() > 0 && findExit && bestAction == 2 && robots[j]->getWeight() < MAX_WEIGHT && std::sqrt(pow(goalX - robots[j]->getBox().x, 2) + pow(goalY - robots[j]->getBox().y, 2)) < std::sqrt(pow(goalX - robots[i]->getBox().x, 2) + pow(goalY - robots[i]->getBox().y, 2))) {
-													recipientSpace = MAX_WEIGHT - robots[recipientRobot]->getWeight();
-
-													// Find largest item that can be passed
-													for (int k = 0; k < MAX_WEIGHT; k++) {
-														if (weightOf(robots[i]->getItem(k)) > weightOf(itemToPass) && weightOf(robots[i]->getItem(k)) <= recipientSpace) itemToPass = robots[i]->getItem(k);
-													}
-
-													if (itemToPass > 0) {
-														passItemAway = true;
-														recipientRobot = j;
-														passDir = 2;
-														break;
-													}
-												}
-											}
-											else if (robots[j]->getBox().x == robots[i]->getBox().x + WH) {
-												f[3] = std::numeric_limits<double>::infinity();
-
-												if (robots[j]->getBattery() > 0 && findExit && bestAction == 3 && robots[j]->getWeight() < MAX_WEIGHT && std::sqrt(pow(goalX - robots[j]->getBox().x, 2) + pow(goalY - robots[j]->getBox().y, 2)) < std::sqrt(pow(goalX - robots[i]->getBox().x, 2) + pow(goalY - robots[i]->getBox().y, 2))) {
-													recipientSpace = MAX_WEIGHT - robots[recipientRobot]->getWeight();
-
-													// Find largest item that can be passed
-													for (int k = 0; k < MAX_WEIGHT; k++) {
-														if (weightOf(robots[i]->getItem(k)) > weightOf(itemToPass) && weightOf(robots[i]->getItem(k)) <= recipientSpace) itemToPass = robots[i]->getItem(k);
-													}
-
-													if (itemToPass > 0) {
-														passItemAway = true;
-														recipientRobot = j;
-														passDir = 3;
-														break;
-													}
-												}
-											}
-										}
-									}
-								}
-
-								// Choose minimum f(n)
-								bestAction = 0;
-								for (int j = 1; j < 4; j++) {
-									if (f[j] < f[bestAction]) {
-										bestAction = j;
-									}
-								}
-
-								// Prints to check on robots
-								/*printf("\nRobot %d\n", i);
-								printf("\nStatus:\t [0]: %lf [1]: %lf [2]: %lf [3]: %lf\n", f[0], f[1], f[2], f[3]);
-								printf("Weight: %d\n", robots[i]->getWeight());
-								printf("Items: ");
-								for (int j = 0; j < MAX_WEIGHT; j++) {
-									printf("%d ", robots[i]->getItem(j));
-								}
-								printf("\n\tsubmit: %d\n", submit);
-								printf("\tchargeBattery: %d\n", chargeBattery);
-								printf("\ttakeItemFromShelf: %d\n", takeItemFromShelf);
-								printf("\tfindShelf: %d\n", findShelf);
-								printf("\tfindExit: %d\n", findExit);
-								printf("\tfindCharger: %d\n", findCharger);
-								printf("\texplore: %d\n", explore);
-								printf("\treceivingItem: %d\n", receivingItem[i]);
-								printf("\twaitingForCharger: %d\n", waitingForCharger);
-								printf("\trescueRobot: %d\n", rescueRobot);*/
-								//for (int j = 0; j < NUMBER_ITEMS_RETRIEVE; j++) {
-								//	if (predItemList[j] != 0) printf("%d ", predItemList[j]);
-								//}
-
-								// Decide action
-								// If waiting for charger, stay still
-								// If receiving item, stay still
-								if (!waitingForCharger && !receivingItem[i]) {
-									if (submit) robots[i]->submitItems(tileDatabase, itemList);
-									else if (chargeBattery) robots[i]->charge(tileDatabase);
-									else if (takeRobotItems) {
-										// Turn to dead robot if not already facing it
-										if (robots[i]->getDir() != takeDir) robots[i]->turn(takeDir);
-										// Take item from dead robot
-										else robots[i]->takeRobotItem(tiles, robots);
-									}
-									else if (takeItemFromShelf) {
-										// Turn to shelf if not already facing it
-										if (robots[i]->getDir() != takeDir) robots[i]->turn(takeDir);
-										// Take item from shelf
-										else robots[i]->takeShelfItem(tiles, predItemList);
-									}
-									else if (passItemAway) {
-										if (robots[i]->getDir() != passDir) robots[i]->turn(passDir);
-										else {
-											robots[i]->passItem(robots, tileDatabase, itemToPass);
-											receivingItem[recipientRobot] = true;
-										}
-									}
-									// Turn to direction if not already facing it
-									else if (robots[i]->getDir() != bestAction) robots[i]->turn(bestAction);
-									// Move
-									else robots[i]->move(tiles, robots);
-								}
-
-								robots[i]->sight(tiles, tileDatabase);
-								robots[i]->updateHistory(tileDatabase);
-
-								// Count items retrieved
-								itemsRetrieved = 0;
-								for (int j = 0; j < NUMBER_ITEMS_RETRIEVE; j++) {
-									if (itemList[j] == 0) itemsRetrieved++;
-								}
-								
-								// Check if all items have been successfully retrieved
-								if (itemsRetrieved == NUMBER_ITEMS_RETRIEVE) {
-									// End the simulation
-									printf("Completed!\n");
-									if (saveResults) successfulRuns++;
-									quit = true;
-									finishSimulation = true;
-								}
-
-								// Count dead robots
-								numDeadRobots = 0;
-								for (int i = 0; i < MAX_ROBOTS; i++) {
-									if (robots[i] != nullptr) {
-										if (robots[i]->getBattery() <= 0) numDeadRobots++;
-									}
-								}
-
-								// Check if run is doomed to fail or told to skip
-								if (numDeadRobots > 0.5 * NUMBER_ROBOTS || skip || (ticks > 5000 && saveResults)) {
-									// End the simulation
-									printf("Failed!\n");
-									if (saveResults) failedRuns++;
-									quit = true;
-									finishSimulation = true;
-								}
-							}
-							// If robot battery is <= 0 and has items on it
-							else if (robots[i]->getWeight() > 0) {
-								double distance = std::numeric_limits<double>::infinity();
-
-								// Find closest surviving robot with sufficient battery and no items on hand
-								for (int j = 0; j < MAX_ROBOTS; j++) {
-									if (robots[j] != nullptr) {
-										if (robots[j]->getBattery() >= 50 && robots[j]->getWeight() == 0) {
-											if (std::sqrt(pow(robots[j]->getBox().x - robots[i]->getBox().x, 2) + pow(robots[j]->getBox().y - robots[i]->getBox().y, 2)) < distance) {
-												distance = std::sqrt(pow(robots[j]->getBox().x - robots[i]->getBox().x, 2) + pow(robots[j]->getBox().y - robots[i]->getBox().y, 2));
-												deadRobot[i] = j;
-											}
-										}
-									}
-								}
-							}
-							else deadRobot[i] = 0;
-						}
+					if (!sim->step()) {
+						// End the simulation
+						if (sim->isCompleted()) printf("Completed!\n");
+						if (sim->isFailed()) printf("Failed!\n");
+						quit = true;
+						finishSimulation = true;
 					}
+					ticks = sim->getTicks();
+					numDeadRobots = sim->getNumDeadRobots();
 					lastTick = SDL_GetTicks64();
 				}
 
@@ -2405,34 +1076,35 @@ int simulation(bool saveResults, int iteration) {
 				camera.y += camVelY;
 			}
 
+			uint64_t renderStart = sim->getProfiler().now();
+
 			// Reset screen
 			SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0xFF);
 			SDL_RenderClear(renderer);
 
 			// Render tiles
 			if (view) {
-				for (int i = 0; i < MAX_TILES; i++) {
-					if (tiles[i] != nullptr) {
-						tiles[i]->render(camera);
-					}
+				for (int i = 0; i < sim->getTiles().size(); i++) {
+					renderTile(sim->getTiles(), i, camera);
 				}
 			}
 			// Render robots' known tiles
 			else {
-				for (int i = 0; i < MAX_TILES; i++) {
-					if (tileDatabase[i] != nullptr) {
-						tileDatabase[i]->render(camera);
-					}
+				for (int i = 0; i < sim->getKnownTiles().size(); i++) {
+					renderTile(sim->getKnownTiles(), i, camera);
 				}
 			}
 
 			// Render robots
 			for (int i = 0; i < NUMBER_ROBOTS; i++) {
-				if (robots[i] != nullptr) {
-					robots[i]->render(camera);
+				if (sim->getRobot(i) != nullptr) {
+					renderRobot(sim->getRobot(i), camera);
 				}
 			}
 
+			// Render tick timings
+			if (showProfile) renderProfile(sim->getProfiler());
+
 			// Darken screen when paused
 			if (pause) {
 				blackScreenTextureClip = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
@@ -2451,29 +1123,15 @@ int simulation(bool saveResults, int iteration) {
 
 			// Update the screen
 			SDL_RenderPresent(renderer);
+			sim->getProfiler().recordFrame(PHASE_RENDER, renderStart);
 		}
 	}
 
-	// Delete tiles
-	for (int i = 0; i < MAX_TILES; i++) {
-		if (tiles[i] != nullptr) {
-			delete tiles[i];
-			tiles[i] = nullptr;
-		}
-
-		if (tileDatabase[i] != nullptr) {
-			delete tileDatabase[i];
-			tileDatabase[i] = nullptr;
-		}
-	}
-
-	// Delete robots
-	for (int i = 0; i < NUMBER_ROBOTS; i++) {
-		if (robots[i] != nullptr) {
-			delete robots[i];
-			robots[i] = nullptr;
-		}
-	}
+	// Delete simulation
+	itemsRetrieved = sim->getItemsRetrieved();
+	float seconds = (float)(SDL_GetTicks64() - runtime) / (float)1000;
+	bool traceSaved = sim->getTrace().isRecording() && sim->getTrace().save(LAST_TRACE_PATH);
+	delete sim;
 
 	// Delete buttons
 	for (int i = 0; i < MAX_BUTTONS; i++) {
@@ -2485,31 +1143,283 @@ int simulation(bool saveResults, int iteration) {
 
 	if (returnMenu) menu();
 	else if (finishSimulation) {
-		itemsRetrieved = 0;
-		for (int i = 0; i < NUMBER_ITEMS_RETRIEVE; i++) {
-			if (itemList[i] == 0) itemsRetrieved++;
+		// Display results
+		printf("Total Ticks: %d\n", ticks);
+		if (itemsRetrieved > 0) printf("Average ticks per item: %f\n", (float)ticks / (float)itemsRetrieved);
+		printf("Items retrieved: %d\n", itemsRetrieved);
+		printf("Number of dead robots: %d\n", numDeadRobots);
+		printf("Simulation run time: %f\n", seconds);
+		if (traceSaved) printf("Trace saved to %s; press R in the menu to replay it\n", LAST_TRACE_PATH.c_str());
+		printf("-------------------------------------------\n");
+	}
+}
+
+// Plays back a recorded trace at any speed, with a timeline to scrub back and forth through it
+int replay(const std::string& path) {
+	TraceReplay* trace = new TraceReplay();
+	if (!trace->load(path)) {
+		printf("Could not replay %s\n", path.c_str());
+		printf("-------------------------------------------\n");
+		delete trace;
+		menu();
+		return 1;
+	}
+
+	// Initialise variables
+	SDL_FRect camera = { 0, 0, (float)SCREEN_WIDTH / SCREEN_SCALE, (float)SCREEN_HEIGHT / SCREEN_SCALE };
+	float camSpd = 10;
+	float camVelX = 0;
+	float camVelY = 0;
+	SDL_Event e;
+
+	// Timeline along the bottom of the screen
+	SDL_FRect timeline = { 20, (float)SCREEN_HEIGHT - 40, (float)SCREEN_WIDTH - 40, 16 };
+	int ticksShown = std::max(trace->getLastTick() - trace->getFirstTick(), 1);
+
+	// Create buttons
+	buttons[0] = new Button(SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2, "Resume");
+	buttons[3] = new Button(SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 + 2 * 150, "Quit");
+	buttons[2] = new Button(SCREEN_WIDTH / 2, SCREEN_HEIGHT / 2 + 150, "Menu");
+	for (int i = 0; i < MAX_BUTTONS; i++) {
+		if (buttons[i] != nullptr) buttons[i]->setShown();
+	}
+
+	// Print settings
+	printf("Replaying %s:\n", path.c_str());
+	printf("> Map %d\n", trace->getSettings().mapNumber);
+	if (trace->getNumberOfRobots() == 1) printf("> %d robot\n", trace->getNumberOfRobots());
+	else printf("> %d robots\n", trace->getNumberOfRobots());
+	printf("> %d obstacles\n", trace->getSettings().numberObstacles);
+	printf("> Seed %llu\n", (unsigned long long)trace->getSeed());
+	printf("> Ticks %d to %d\n\n", trace->getFirstTick(), trace->getLastTick());
+
+	// Event flag
+	bool returnMenu = false;
+
+	bool quit = false;
+	bool pause = false;
+	bool playing = true;
+	bool scrubbing = false; // Dragging along the timeline
+	bool view = false; // false: real layout, true: robots' knowledge of the layout
+	double ticksDue = 0; // Ticks to play, carried over between frames
+	Uint64 lastFrame = SDL_GetTicks64();
+
+	// Main loop
+	while (!quit) {
+		// Handle events
+		while (SDL_PollEvent(&e) != 0) {
+			// The close button
+			if (e.type == SDL_QUIT) quit = true;
+
+			// Step back or forward a tick, holding the key to keep stepping
+			else if (e.type == SDL_KEYDOWN && (e.key.keysym.sym == SDLK_COMMA || e.key.keysym.sym == SDLK_PERIOD)) {
+				if (!pause) {
+					playing = false;
+					trace->seek(trace->getTick() + (e.key.keysym.sym == SDLK_PERIOD ? 1 : -1));
+				}
+			}
+
+			else if (e.type == SDL_KEYDOWN && e.key.repeat == 0) {
+				switch (e.key.keysym.sym) {
+					// Pause by pressing ESC
+				case SDLK_ESCAPE:
+					pause = !pause;
+					for (int i = 0; i < MAX_BUTTONS; i++) {
+						if (buttons[i] != nullptr) buttons[i]->setShown();
+					}
+					camVelX = 0;
+					camVelY = 0;
+					scrubbing = false;
+					break;
+					// Move camera using arrow keys
+				case SDLK_UP: camVelY -= camSpd; break;
+				case SDLK_DOWN: camVelY += camSpd; break;
+				case SDLK_LEFT: camVelX -= camSpd; break;
+				case SDLK_RIGHT: camVelX += camSpd; break;
+					// Zoom
+				case SDLK_w: // Out
+					if (!pause) {
+						if (SCREEN_SCALE > 0.5) SCREEN_SCALE -= 0.5;
+						camera.w = (float)SCREEN_WIDTH / SCREEN_SCALE;
+						camera.h = (float)SCREEN_HEIGHT / SCREEN_SCALE;
+					}
+					break;
+				case SDLK_e: // In
+					if (!pause) {
+						if (SCREEN_SCALE < 5.5) SCREEN_SCALE += 0.5;
+						camera.w = (float)SCREEN_WIDTH / SCREEN_SCALE;
+						camera.h = (float)SCREEN_HEIGHT / SCREEN_SCALE;
+					}
+					break;
+				case SDLK_r: // Reset
+					if (!pause) {
+						SCREEN_SCALE = 1.5;
+						camera = { 0, 0, (float)SCREEN_WIDTH / SCREEN_SCALE, (float)SCREEN_HEIGHT / SCREEN_SCALE };
+						camVelX = 0;
+						camVelY = 0;
+					}
+					break;
+					// Switch between real layout and robots' knowledge of the layout
+				case SDLK_TAB: if (!pause) view = !view; break;
+					// Play or stop, starting again from the beginning at the end of the trace
+				case SDLK_SPACE:
+					if (!pause) {
+						if (!playing && trace->getTick() >= trace->getLastTick()) trace->seek(trace->getFirstTick());
+						playing = !playing;
+						ticksDue = 0;
+					}
+					break;
+					// Slower or faster
+				case SDLK_MINUS: if (REPLAY_SPEED > 1) REPLAY_SPEED /= 2; break;
+				case SDLK_EQUALS: if (REPLAY_SPEED < MAX_REPLAY_SPEED) REPLAY_SPEED *= 2; break;
+					// Jump to the start or end
+				case SDLK_HOME: if (!pause) trace->seek(trace->getFirstTick()); break;
+				case SDLK_END: if (!pause) trace->seek(trace->getLastTick()); break;
+				}
+			}
+
+			else if (e.type == SDL_KEYUP && e.key.repeat == 0) {
+				switch (e.key.keysym.sym) {
+				case SDLK_UP: camVelY += camSpd; break;
+				case SDLK_DOWN: camVelY -= camSpd; break;
+				case SDLK_LEFT: camVelX += camSpd; break;
+				case SDLK_RIGHT: camVelX -= camSpd; break;
+				}
+			}
+
+			// Scrub by clicking on or dragging along the timeline
+			else if (!pause && (e.type == SDL_MOUSEBUTTONDOWN || e.type == SDL_MOUSEMOTION || e.type == SDL_MOUSEBUTTONUP)) {
+				SDL_FPoint cursor = { 0, 0 };
+				if (e.type == SDL_MOUSEMOTION) cursor = { (float)e.motion.x, (float)e.motion.y };
+				else cursor = { (float)e.button.x, (float)e.button.y };
+
+				if (e.type == SDL_MOUSEBUTTONDOWN && e.button.button == SDL_BUTTON_LEFT && SDL_PointInFRect(&cursor, &timeline)) scrubbing = true;
+				else if (e.type == SDL_MOUSEBUTTONUP) scrubbing = false;
+
+				if (scrubbing) {
+					float position = std::max((float)0, std::min((cursor.x - timeline.x) / timeline.w, (float)1));
+					trace->seek(trace->getFirstTick() + (int)(position * (float)ticksShown + (float)0.5));
+				}
+			}
+
+			// Resume button
+			if (buttons[0]->isShown() && buttons[0]->handleEvents(e)) {
+				pause = !pause;
+				for (int i = 0; i < MAX_BUTTONS; i++) {
+					if (buttons[i] != nullptr) buttons[i]->setShown();
+				}
+			}
+
+			// Quit button
+			if (buttons[3]->isShown() && buttons[3]->handleEvents(e)) {
+				quit = true;
+				return 0;
+			}
+
+			// Menu button
+			if (buttons[2]->isShown() && buttons[2]->handleEvents(e)) {
+				quit = true;
+				returnMenu = true;
+			}
+		}
+
+		// Play the ticks due since the last frame
+		Uint64 now = SDL_GetTicks64();
+		if (!pause) {
+			if (playing && !scrubbing) {
+				ticksDue += (double)(now - lastFrame) * REPLAY_SPEED / 1000;
+				if (ticksDue >= 1) {
+					trace->seek(trace->getTick() + (int)ticksDue);
+					ticksDue -= (int)ticksDue;
+				}
+				if (trace->getTick() >= trace->getLastTick()) playing = false;
+			}
+
+			// Process camera movement
+			camera.x += camVelX;
+			camera.y += camVelY;
+		}
+		lastFrame = now;
+
+		// Reset screen
+		SDL_SetRenderDrawColor(renderer, 0x00, 0x00, 0x00, 0xFF);
+		SDL_RenderClear(renderer);
+
+		// Render tiles
+		if (view) {
+			for (int i = 0; i < trace->getTiles().size(); i++) {
+				renderTile(trace->getTiles(), i, camera);
+			}
+		}
+		// Render robots' known tiles
+		else {
+			for (int i = 0; i < trace->getKnownTiles().size(); i++) {
+				renderTile(trace->getKnownTiles(), i, camera);
+			}
 		}
 
-		if (!saveResults) {
-			// Display results
-			printf("Total Ticks: %d\n", ticks);
-			if (itemsRetrieved > 0) printf("Average ticks per item: %f\n", (float)ticks / (float)itemsRetrieved);
-			printf("Items retrieved: %d\n", itemsRetrieved);
-			printf("Number of dead robots: %d\n", numDeadRobots);
-			printf("Simulation run time: %f\n", (float)(SDL_GetTicks64() - runtime) / (float)1000);
+		// Render robots
+		for (int i = 0; i < trace->getNumberOfRobots(); i++) {
+			renderRobot(trace->getRobot(i), camera);
 		}
-		else if (itemsRetrieved == 100) {
-			// Save results if run was successful
-			ticksTaken[iteration] = ticks;
-			ticksTakenPerItem[iteration] = (float)ticks / (float)itemsRetrieved;
-			numberDeadRobots[iteration] = numDeadRobots;
-			timeTaken[iteration] = (float)(SDL_GetTicks64() - runtime) / (float)1000;
+
+		// Render the tick, metrics and speed
+		float lineHeight = (float)FONT_SIZE * (float)1.1;
+		textObj.str("");
+		textObj << "Tick " << trace->getTick() << " of " << trace->getLastTick();
+		renderText(textObj.str(), 10, 10, false, true);
+		textObj.str("");
+		textObj << "Items retrieved: " << trace->getItemsRetrieved() << ", dead robots: " << trace->getNumDeadRobots();
+		renderText(textObj.str(), 10, 10 + lineHeight, false, true);
+		textObj.str("");
+		textObj << REPLAY_SPEED << " ticks per second" << (playing ? "" : " (stopped)");
+		renderText(textObj.str(), 10, 10 + 2 * lineHeight, false, true);
+		renderText("Space: play or stop, - and =: speed, comma and full stop: step, Home and End: jump, Tab: view", 10, timeline.y - lineHeight - 10, false, true);
+
+		// Render the timeline and how far through it the replay is
+		SDL_SetRenderDrawColor(renderer, 0x40, 0x40, 0x40, 0xFF);
+		SDL_RenderFillRectF(renderer, &timeline);
+		SDL_FRect played = timeline;
+		played.w *= (float)(trace->getTick() - trace->getFirstTick()) / (float)ticksShown;
+		SDL_SetRenderDrawColor(renderer, 0x46, 0xa2, 0xFF, 0xFF);
+		SDL_RenderFillRectF(renderer, &played);
+
+		// Darken screen when paused
+		if (pause) {
+			blackScreenTextureClip = { 0, 0, SCREEN_WIDTH, SCREEN_HEIGHT };
+			blackScreenTexture.render(0, 0, &blackScreenTextureClip);
 		}
-		printf("-------------------------------------------\n");
 
-		if (skip) return 2;
+		// Render buttons
+		for (int i = 0; i < MAX_BUTTONS; i++) {
+			if (buttons[i] != nullptr) {
+				buttons[i]->render();
+			}
+		}
+
+		// Render "Paused"
+		if (pause) renderTitle("Paused", (float)SCREEN_WIDTH / 2, 150, true, true);
+
+		// Update the screen
+		SDL_RenderPresent(renderer);
 	}
 
+	printf("Replayed up to tick %d of %d\n", trace->getTick(), trace->getLastTick());
+	printf("Items retrieved: %d\n", trace->getItemsRetrieved());
+	printf("Number of dead robots: %d\n", trace->getNumDeadRobots());
+	printf("-------------------------------------------\n");
+	delete trace;
+
+	// Delete buttons
+	for (int i = 0; i < MAX_BUTTONS; i++) {
+		if (buttons[i] != nullptr) {
+			delete buttons[i];
+			buttons[i] = nullptr;
+		}
+	}
+
+	if (returnMenu) menu();
+
 	return 1;
 }
 
@@ -2528,8 +1438,9 @@ int main(int argc, char** argv) {
 		return false;
 	}
 
-	// Open the warehouse robot simulation menu
-	menu();
+	// Replay a trace given on the command line, or open the warehouse robot simulation menu
+	if (argc > 1) replay(argv[1]);
+	else menu();
 
 	// Close SDL library
 	closeSDL();
@@ -2540,4 +1451,4 @@ int main(int argc, char** argv) {
 	std::cin >> i;
 
 	return 0;
-}
\ No newline at end of file
+}
\ No newline at end of file
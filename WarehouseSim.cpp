@@ -0,0 +1,1281 @@
+#include "WarehouseSim.h"
+#include "MapFile.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+
+bool mapSizeOf(int mapNumber, int& width, int& height) {
+	MapFile map;
+	if (!map.open(mapPathOf(mapNumber))) return false;
+
+	width = map.getWidth();
+	height = map.getHeight();
+	return true;
+}
+
+std::string mapPathOf(int mapNumber) {
+	std::string path = "warehouse_resources/map" + std::to_string(mapNumber);
+
+	// Use the binary map made by the map converter if there is one, as it loads faster
+	if (std::ifstream(path + ".wmap").good()) return path + ".wmap";
+	else return path + ".map";
+}
+
+std::vector<TestSetting> logicalTestSettings() {
+	std::vector<TestSetting> settings;
+	for (int i = 1; i <= 8; i++) {
+		// Larger maps get more robots; maps that cannot be read are treated as medium maps
+		int width = 50;
+		int height = 50;
+		mapSizeOf(i, width, height);
+
+		if (std::max(width, height) <= 25) {
+			settings.push_back({ i, 10, 15 });
+			settings.push_back({ i, 20, 10 });
+			settings.push_back({ i, 20, 5 });
+		}
+		else if (std::max(width, height) <= 50) {
+			settings.push_back({ i, 15, 25 });
+			settings.push_back({ i, 30, 15 });
+			settings.push_back({ i, 50, 5 });
+		}
+		else {
+			settings.push_back({ i, 50, 100 });
+			settings.push_back({ i, 100, 50 });
+			settings.push_back({ i, 100, 100 });
+		}
+	}
+	return settings;
+}
+
+std::vector<TestSetting> allTestSettings() {
+	std::vector<TestSetting> settings;
+	// i is the map number
+	for (int i = 1; i <= 8; i++) {
+		// j is the number of robots
+		for (int j = 1; j <= 100; j += 10) {
+			if (j == 11) j--;
+			if (j > 1 && j <= 35) j -= 5;
+
+			// k is the number of obstacles
+			for (int k = 0; k <= 100; k += 10) {
+				if (k > 0 && k <= 35) k -= 5;
+
+				settings.push_back({ i, j, k });
+			}
+		}
+	}
+	return settings;
+}
+
+// Pool of threads that run a job for every robot and wait for the next tick in between
+class TickWorkers {
+public:
+	TickWorkers(int threads) {
+		int numberThreads = threads;
+		if (numberThreads <= 0) numberThreads = (int)std::thread::hardware_concurrency();
+		// The calling thread works too
+		for (int i = 1; i < numberThreads; i++) {
+			pool.emplace_back([this]() { work(); });
+		}
+	}
+	~TickWorkers() {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (std::thread& thread : pool) thread.join();
+	}
+
+	// Run the job for 0 to count - 1, returning once every call has finished
+	void run(int count, const std::function<void(int)>& runJob) {
+		if (pool.empty()) {
+			for (int i = 0; i < count; i++) runJob(i);
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			job = &runJob;
+			numberOfJobs = count;
+			next = 0;
+			busy = (int)pool.size();
+			generation++;
+		}
+		wake.notify_all();
+		runChunks();
+
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [this]() { return busy == 0; });
+		job = nullptr;
+	}
+private:
+	// Robots taken at a time, so threads do not fight over the counter
+	static constexpr int CHUNK = 64;
+
+	void work() {
+		int seenGeneration = 0;
+		while (true) {
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				wake.wait(lock, [&]() { return stopping || generation != seenGeneration; });
+				if (stopping) return;
+				seenGeneration = generation;
+			}
+			runChunks();
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				busy--;
+			}
+			done.notify_one();
+		}
+	}
+	void runChunks() {
+		int first = 0;
+		while ((first = next.fetch_add(CHUNK)) < numberOfJobs) {
+			int last = std::min(first + CHUNK, numberOfJobs);
+			for (int i = first; i < last; i++) (*job)(i);
+		}
+	}
+
+	std::vector<std::thread> pool;
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	const std::function<void(int)>* job = nullptr;
+	int numberOfJobs = 0;
+	std::atomic<int> next{ 0 };
+	int busy = 0;
+	int generation = 0;
+	bool stopping = false;
+};
+
+WarehouseSim::WarehouseSim(const SimSettings& simSettings, uint64_t simSeed) : settings(simSettings), seed(simSeed), random(simSeed) {
+	profiler.setEnabled(settings.profile);
+}
+
+WarehouseSim::~WarehouseSim() {
+	// Delete robots
+	for (int i = 0; i < (int)robots.size(); i++) {
+		if (robots[i] != nullptr) {
+			delete robots[i];
+			robots[i] = nullptr;
+		}
+	}
+}
+
+void writeSettings(SnapshotWriter& out, const SimSettings& settings) {
+	out.write(settings.mapNumber);
+	out.write(settings.mapPath);
+	out.write(settings.mapWidth);
+	out.write(settings.mapHeight);
+	out.write(settings.numberRobots);
+	out.write(settings.numberObstacles);
+	out.write(settings.numberItems);
+	out.write(settings.maxTicks);
+	out.write(settings.twoPhaseTicks);
+	out.write(settings.tickThreads);
+	out.write(settings.profile);
+	out.write(settings.recordThroughput);
+	out.write(settings.recordTrace);
+}
+
+void readSettings(SnapshotReader& in, SimSettings& settings) {
+	in.read(settings.mapNumber);
+	in.read(settings.mapPath);
+	in.read(settings.mapWidth);
+	in.read(settings.mapHeight);
+	in.read(settings.numberRobots);
+	in.read(settings.numberObstacles);
+	in.read(settings.numberItems);
+	in.read(settings.maxTicks);
+	in.read(settings.twoPhaseTicks);
+	in.read(settings.tickThreads);
+	in.read(settings.profile);
+	in.read(settings.recordThroughput);
+	in.read(settings.recordTrace);
+}
+
+namespace {
+	// Start of every snapshot, and the version of its layout
+	constexpr uint32_t SNAPSHOT_MAGIC = 0x504E5357; // "WSNP"
+	constexpr uint32_t SNAPSHOT_VERSION = 2;
+}
+
+std::vector<uint8_t> WarehouseSim::takeSnapshot() const {
+	SnapshotWriter out;
+	out.write(SNAPSHOT_MAGIC);
+	out.write(SNAPSHOT_VERSION);
+	writeSettings(out, settings);
+	out.write(seed);
+	uint64_t randomState[4];
+	random.getState(randomState);
+	out.write(randomState);
+
+	tiles.save(out);
+	tileDatabase.save(out);
+	out.write((uint64_t)robots.size());
+	for (Robot* robot : robots) {
+		out.write((uint8_t)(robot != nullptr));
+		if (robot != nullptr) robot->save(out);
+	}
+	robotGrid.save(out);
+	spawnTiles.save(out);
+	freeFloor.save(out);
+	out.write(obstacles);
+	idleRobots.save(out);
+	out.write(numberOfShelves);
+
+	orders.save(out);
+	out.write(changedTiles);
+	chargerField.save(out);
+	exitField.save(out);
+	frontierField.save(out);
+	unknownTiles.save(out);
+	out.write(goals);
+	out.write(receivingItem);
+	out.write(chargerKnown);
+	out.write(deadRobot);
+	out.write(robotsToRescue);
+	out.write(currentGoal);
+	out.write(decisions);
+	out.write(actOrder);
+
+	out.write(ticks);
+	out.write(numDeadRobots);
+	out.write(skipRequested);
+	out.write(finished);
+	out.write(completed);
+	out.write(failed);
+	out.write(failureReason);
+	out.write(throughput);
+	out.write(throughputRetrieved);
+	return out.getBytes();
+}
+
+bool WarehouseSim::saveSnapshot(const std::string& path) const {
+	std::vector<uint8_t> snapshot = takeSnapshot();
+	std::ofstream file(path.c_str(), std::ios::binary);
+	file.write((const char*)snapshot.data(), (std::streamsize)snapshot.size());
+	return !file.fail();
+}
+
+std::unique_ptr<WarehouseSim> WarehouseSim::fromSnapshot(const std::vector<uint8_t>& snapshot) {
+	SnapshotReader in(snapshot);
+	uint32_t magic = 0;
+	uint32_t version = 0;
+	in.read(magic);
+	in.read(version);
+	if (magic != SNAPSHOT_MAGIC || version != SNAPSHOT_VERSION) return nullptr;
+
+	SimSettings settings;
+	readSettings(in, settings);
+	uint64_t seed = 0;
+	in.read(seed);
+	std::unique_ptr<WarehouseSim> sim(new WarehouseSim(settings, seed));
+	uint64_t randomState[4];
+	in.read(randomState);
+	sim->random.setState(randomState);
+
+	sim->tiles.load(in);
+	sim->tileDatabase.load(in);
+	uint64_t numberOfRobots = 0;
+	in.read(numberOfRobots);
+	for (uint64_t i = 0; i < numberOfRobots && in.isValid(); i++) {
+		uint8_t present = 0;
+		in.read(present);
+		sim->robots.push_back(present ? new Robot(0, 0, 0) : nullptr);
+		if (present) sim->robots.back()->load(in);
+	}
+	sim->robotGrid.load(in);
+	sim->spawnTiles.load(in);
+	sim->freeFloor.load(in);
+	in.read(sim->obstacles);
+	sim->idleRobots.load(in);
+	in.read(sim->numberOfShelves);
+
+	sim->orders.load(in);
+	in.read(sim->changedTiles);
+	sim->chargerField.load(in);
+	sim->exitField.load(in);
+	sim->frontierField.load(in);
+	sim->unknownTiles.load(in);
+	in.read(sim->goals);
+	in.read(sim->receivingItem);
+	in.read(sim->chargerKnown);
+	in.read(sim->deadRobot);
+	in.read(sim->robotsToRescue);
+	in.read(sim->currentGoal);
+	in.read(sim->decisions);
+	in.read(sim->actOrder);
+
+	in.read(sim->ticks);
+	in.read(sim->numDeadRobots);
+	in.read(sim->skipRequested);
+	in.read(sim->finished);
+	in.read(sim->completed);
+	in.read(sim->failed);
+	in.read(sim->failureReason);
+	in.read(sim->throughput);
+	in.read(sim->throughputRetrieved);
+
+	// The grids must all match the size of the map
+	int numberOfTiles = settings.mapWidth / WH * (settings.mapHeight / WH);
+	if (!in.isValid() || !in.isAtEnd() || sim->tiles.size() != numberOfTiles || sim->tileDatabase.size() != numberOfTiles) return nullptr;
+	for (Robot* robot : sim->robots) {
+		if (robot != nullptr && !sim->tiles.contains(robot->getTile())) return nullptr;
+	}
+	return sim;
+}
+
+std::unique_ptr<WarehouseSim> WarehouseSim::loadSnapshot(const std::string& path) {
+	std::ifstream file(path.c_str(), std::ios::binary);
+	if (file.fail()) return nullptr;
+	std::vector<uint8_t> snapshot((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	return fromSnapshot(snapshot);
+}
+
+std::unique_ptr<WarehouseSim> WarehouseSim::fork(const SimSettings& variant, uint64_t variantSeed) const {
+	std::unique_ptr<WarehouseSim> copy = fromSnapshot(takeSnapshot());
+	if (copy == nullptr) return nullptr;
+
+	copy->settings.numberObstacles = variant.numberObstacles;
+	copy->settings.maxTicks = variant.maxTicks;
+	copy->settings.twoPhaseTicks = variant.twoPhaseTicks;
+	copy->settings.tickThreads = variant.tickThreads;
+	copy->settings.profile = variant.profile;
+	copy->settings.recordThroughput = variant.recordThroughput;
+	copy->settings.recordTrace = variant.recordTrace;
+	copy->profiler.setEnabled(variant.profile);
+
+	copy->seed = variantSeed;
+	copy->random.setSeed(variantSeed);
+	return copy;
+}
+
+bool WarehouseSim::loadMap() {
+	if (readMap()) return true;
+	printf("loadMap() error: could not load %s\n", settings.mapPath.c_str());
+	return false;
+}
+
+bool WarehouseSim::readMap() {
+	bool success = true;
+	numberOfShelves = 0;
+
+	// Load map file
+	MapFile map;
+	if (!map.open(settings.mapPath)) return false;
+
+	// The map file decides the size of the map
+	settings.mapWidth = map.getWidth() * WH;
+	settings.mapHeight = map.getHeight() * WH;
+
+	// All tiles start unknown to the robots
+	tiles.reset(map.getWidth(), map.getHeight());
+	tileDatabase.reset(map.getWidth(), map.getHeight());
+	robotGrid.reset(tiles.size());
+	spawnTiles.reset(tiles.size());
+	freeFloor.reset(tiles.size());
+	obstacles.clear();
+	idleRobots.reset(map.getWidth(), map.getHeight(), settings.numberRobots);
+	unknownTiles.reset(map.getWidth(), map.getHeight(), tiles.size());
+
+	const uint8_t* mapTiles = map.getTiles();
+	for (int i = 0; i < tiles.size(); i++) {
+		int tileType = mapTiles[i];
+
+		// Create tiles
+		if (tileType <= TILE_SPRITES) {
+			// Set the first 10 shelves to have items 1 to 10. Remaining shelves have random items.
+			if (tileType >= 2 && tileType <= 5) {
+				tiles.setTile(i, tileType, numberOfShelves + 1, weightOf(numberOfShelves + 1));
+
+				numberOfShelves++;
+			}
+			else tiles.setTile(i, tileType);
+		}
+		else {
+			printf("Invalid tile type at %d\n", i);
+			success = false;
+			break;
+		}
+	}
+	if (!success || numberOfShelves == 0) return false;
+
+	// in tileDatabase, set all black tiles (type 0)
+	for (int i = 0; i < tiles.size(); i++) {
+		if (tiles.getType(i) == 0) tileDatabase.setTileType(i, tiles.getType(i));
+		else unknownTiles.insert(i, i % tiles.getWidth(), i / tiles.getWidth());
+	}
+
+	// Tiles that robots can spawn on and that obstacles can be placed on
+	for (int i = 0; i < tiles.size(); i++) {
+		if (tiles.getType(i) == 1 || (tiles.getType(i) >= 6 && tiles.getType(i) <= 8)) spawnTiles.insert(i);
+		if (tiles.getType(i) == 1) freeFloor.insert(i);
+		// Obstacles in the map file are cleared with the first generated obstacles
+		if (tiles.getType(i) == 9) obstacles.push_back(i);
+	}
+	return true;
+}
+
+void WarehouseSim::spawnRobots() {
+	// Only spawn as many robots as there are walkable tiles
+	if (settings.numberRobots > spawnTiles.size()) {
+		printf("Map has room for only %d of %d robots\n", spawnTiles.size(), settings.numberRobots);
+		settings.numberRobots = spawnTiles.size();
+	}
+
+	robots.assign(settings.numberRobots, nullptr);
+	receivingItem.assign(settings.numberRobots, false);
+	// Only the first robot starts with no robot to rescue it and no goal
+	deadRobot.assign(settings.numberRobots, 0);
+	currentGoal.assign(settings.numberRobots, 0);
+	robotsToRescue.assign(settings.numberRobots, std::set<int>());
+	if (settings.numberRobots > 0) {
+		deadRobot[0] = -1;
+		currentGoal[0] = -1;
+		for (int i = 1; i < settings.numberRobots; i++) robotsToRescue[0].insert(i);
+	}
+
+	for (int i = 0; i < settings.numberRobots; i++) {
+		// Draw a random walkable tile that no robot has spawned on yet
+		int spawnTile = spawnTiles.sample(random);
+		spawnTiles.remove(spawnTile);
+		freeFloor.remove(spawnTile);
+
+		robots[i] = new Robot(tiles.getX(spawnTile), tiles.getY(spawnTile), spawnTile);
+		robotGrid.place(i, spawnTile);
+		updateIdle(i);
+	}
+}
+
+void WarehouseSim::createItemList() {
+	// Every shelf holds its own item, numbered from 1
+	orders.reset(numberOfShelves, tiles.getWidth(), tiles.getHeight());
+	for (int i = 0; i < settings.numberItems; i++) {
+		orders.addOrder(random.nextInt(numberOfShelves) + 1);
+	}
+}
+
+bool WarehouseSim::step() {
+	if (finished) return false;
+
+	uint64_t tickStart = profiler.now();
+
+	// The trace starts from the state before the first tick it records
+	if (settings.recordTrace && !trace.isRecording()) startTrace();
+
+	// Obstacle tile generation and deletion at fixed tick intervals
+	if (ticks % OBSTACLE_CD == 0) generateObstacles();
+	profiler.lap(PHASE_OBSTACLES, tickStart);
+
+	ticks++;
+
+	if (settings.twoPhaseTicks) stepTwoPhase();
+	// The entire decision and pathfinding algorithm is in processRobot()
+	else {
+		for (int i = 0; i < (int)robots.size() && !finished; i++) {
+			if (robots[i] != nullptr) {
+				processRobot(i);
+				updateIdle(i);
+			}
+		}
+	}
+
+	// Items retrieved in this interval of the throughput series
+	if (settings.recordThroughput && (ticks % THROUGHPUT_TICKS == 0 || finished)) {
+		throughput.push_back(getItemsRetrieved() - throughputRetrieved);
+		throughputRetrieved = getItemsRetrieved();
+	}
+
+	trace.endTick();
+	profiler.endTick(tickStart);
+	return !finished;
+}
+
+void WarehouseSim::stepTwoPhase() {
+	int numberOfRobots = (int)robots.size();
+	if (workers == nullptr) workers.reset(new TickWorkers(settings.tickThreads));
+
+	uint64_t time = profiler.now();
+
+	// Bring the paths up to date first, so deciding robots only ever read them
+	updateChargerField();
+	updateExitField();
+	updateFrontierField();
+
+	// Decide phase: every robot decides from the state at the start of the tick
+	decisions.resize(numberOfRobots);
+	workers->run(numberOfRobots, [this](int i) {
+		if (robots[i] != nullptr) decideRobot(i, decisions[i]);
+	});
+	profiler.lap(PHASE_DECIDE, time);
+
+	// Act phase: robots act one at a time in an order shuffled every tick, so no robot always goes first.
+	// Moves into tiles taken earlier in the phase fail and passes to robots that moved away are skipped.
+	uint64_t tickSeed = mixSeed(seed, (uint64_t)ticks);
+	actOrder.resize(numberOfRobots);
+	for (int i = 0; i < numberOfRobots; i++) actOrder[i] = i;
+	std::sort(actOrder.begin(), actOrder.end(), [tickSeed](int a, int b) {
+		return mixSeed(tickSeed, (uint64_t)a) < mixSeed(tickSeed, (uint64_t)b);
+	});
+	for (int n = 0; n < numberOfRobots && !finished; n++) {
+		int i = actOrder[n];
+		if (robots[i] != nullptr) {
+			actRobot(i, decisions[i]);
+			updateIdle(i);
+		}
+	}
+}
+
+void WarehouseSim::generateObstacles() {
+	// Reset all existing obstacle tiles to be floor tiles
+	for (int i = 0; i < (int)obstacles.size(); i++) {
+		tiles.setTileType(obstacles[i], 1);
+		freeFloor.insert(obstacles[i]);
+	}
+	obstacles.clear();
+
+	// Randomly generate obstacle tiles on floor tiles (type == 1) with no robots on them, as long as any are left
+	for (int i = 0; i < settings.numberObstacles && freeFloor.size() > 0; i++) {
+		int obstacleTile = freeFloor.sample(random);
+		freeFloor.remove(obstacleTile);
+		tiles.setTileType(obstacleTile, 9);
+		obstacles.push_back(obstacleTile);
+	}
+	trace.obstacles(obstacles);
+}
+
+void WarehouseSim::startTrace() {
+	// Everything a replay needs to carry out the robots' actions: the map, what the robots know of it, the orders and the robots
+	SnapshotWriter out;
+	writeSettings(out, settings);
+	out.write(seed);
+	out.write(ticks);
+	tiles.saveCompact(out);
+	tileDatabase.saveCompact(out);
+	out.write(obstacles);
+	orders.saveOrders(out);
+	out.write((uint64_t)robots.size());
+	for (Robot* robot : robots) {
+		out.write(robot->getTile());
+		out.write(robot->getDir());
+		out.write(robot->getBattery());
+		for (int j = 0; j < MAX_WEIGHT; j++) out.write(robot->getItem(j));
+	}
+	trace.start(out.getBytes());
+}
+
+void DistanceField::build(const TileGrid& known, const std::vector<int>& goals) {
+	distance.assign(known.size(), UNREACHABLE);
+	open.assign(known.size(), 0);
+	goal.assign(known.size(), 0);
+	isPending.assign(known.size(), 0);
+	raised.assign(known.size(), 0);
+	pending.clear();
+	queue.clear();
+
+	for (int i = 0; i < known.size(); i++) {
+		open[i] = (uint8_t)isPassable(known.getType(i));
+	}
+
+	// Search outwards from every goal at once
+	for (int i = 0; i < (int)goals.size(); i++) {
+		goal[goals[i]] = 1;
+		if (open[goals[i]] && distance[goals[i]] == UNREACHABLE) {
+			distance[goals[i]] = 0;
+			queue.push_back(goals[i]);
+		}
+	}
+	numberOfGoals = (int)queue.size();
+
+	for (int i = 0; i < (int)queue.size(); i++) {
+		int tile = queue[i];
+		for (int j = 0; j < 4; j++) {
+			int next = known.neighbour(tile, j);
+			if (next >= 0 && distance[next] == UNREACHABLE && open[next]) {
+				distance[next] = distance[tile] + 1;
+				queue.push_back(next);
+			}
+		}
+	}
+}
+
+int DistanceField::distanceThroughNeighbours(const TileGrid& known, int tile) const {
+	int best = UNREACHABLE;
+	for (int j = 0; j < 4; j++) {
+		int next = known.neighbour(tile, j);
+		if (next >= 0 && distance[next] != UNREACHABLE && (best == UNREACHABLE || distance[next] + 1 < best)) best = distance[next] + 1;
+	}
+	return best;
+}
+
+void DistanceField::update(const TileGrid& known) {
+	if (pending.empty()) return;
+
+	// Tiles ordered by distance, closest first
+	typedef std::pair<int, int> QueuedTile; // (distance, tile)
+	std::priority_queue<QueuedTile, std::vector<QueuedTile>, std::greater<QueuedTile>> search;
+
+	// Changed tiles that lost their distance: goals that were removed and tiles that became blocked
+	for (int i = 0; i < (int)pending.size(); i++) {
+		int tile = pending[i];
+		bool wasGoal = distance[tile] == 0;
+		open[tile] = (uint8_t)isPassable(known.getType(tile));
+		bool isGoal = goal[tile] && open[tile];
+
+		if (wasGoal != isGoal) numberOfGoals += isGoal ? 1 : -1;
+		if (distance[tile] != UNREACHABLE && (!open[tile] || (wasGoal && !isGoal))) {
+			raised[tile] = 1;
+			queue.push_back(tile);
+			search.push({ distance[tile], tile });
+		}
+	}
+
+	// Raise: any tile whose shortest path went through a lost tile also loses its distance,
+	// unless another neighbour one step closer to a goal still has its distance
+	std::vector<int>& raisedTiles = queue;
+	while (!search.empty()) {
+		int steps = search.top().first;
+		int tile = search.top().second;
+		search.pop();
+
+		// Already spread from this tile
+		if (raised[tile] == 2) continue;
+
+		if (!raised[tile]) {
+			bool supported = false;
+			for (int j = 0; j < 4 && !supported; j++) {
+				int next = known.neighbour(tile, j);
+				if (next >= 0 && !raised[next] && distance[next] == steps - 1) supported = true;
+			}
+			if (supported) continue;
+
+			raisedTiles.push_back(tile);
+		}
+		raised[tile] = 2;
+
+		for (int j = 0; j < 4; j++) {
+			int next = known.neighbour(tile, j);
+			if (next >= 0 && !raised[next] && distance[next] == steps + 1) search.push({ steps + 1, next });
+		}
+	}
+	for (int i = 0; i < (int)raisedTiles.size(); i++) {
+		distance[raisedTiles[i]] = UNREACHABLE;
+	}
+
+	// Lower: give new goals, lost tiles and newly walkable tiles their distance back from their neighbours,
+	// then spread any shorter distances outwards
+	for (int i = 0; i < (int)pending.size() + (int)raisedTiles.size(); i++) {
+		int tile = i < (int)pending.size() ? pending[i] : raisedTiles[i - pending.size()];
+		if (!open[tile]) continue;
+
+		int steps = goal[tile] ? 0 : distanceThroughNeighbours(known, tile);
+		if (steps != UNREACHABLE && (distance[tile] == UNREACHABLE || steps < distance[tile])) {
+			distance[tile] = steps;
+			search.push({ steps, tile });
+		}
+	}
+	while (!search.empty()) {
+		int steps = search.top().first;
+		int tile = search.top().second;
+		search.pop();
+		if (steps != distance[tile]) continue;
+
+		for (int j = 0; j < 4; j++) {
+			int next = known.neighbour(tile, j);
+			if (next >= 0 && open[next] && (distance[next] == UNREACHABLE || steps + 1 < distance[next])) {
+				distance[next] = steps + 1;
+				search.push({ steps + 1, next });
+			}
+		}
+	}
+
+	for (int i = 0; i < (int)pending.size(); i++) {
+		isPending[pending[i]] = 0;
+	}
+	for (int i = 0; i < (int)raisedTiles.size(); i++) {
+		raised[raisedTiles[i]] = 0;
+	}
+	pending.clear();
+	queue.clear();
+}
+
+void WarehouseSim::updateChargerField() {
+	if (chargerField.isBuilt()) {
+		chargerField.update(tileDatabase);
+		return;
+	}
+
+	// Known chargers that no robot is standing on
+	goals.clear();
+	for (int i = 0; i < tileDatabase.size(); i++) {
+		if (tileDatabase.getType(i) == 6 && robotGrid.robotAt(i) < 0) goals.push_back(i);
+	}
+	chargerField.build(tileDatabase, goals);
+}
+
+void WarehouseSim::shelfAccessOf(int shelf, int& x, int& y, int& facing) {
+	x = shelf % tileDatabase.getWidth();
+	y = shelf / tileDatabase.getWidth();
+	facing = 0;
+	switch (tileDatabase.getType(shelf)) {
+	case 2: y--; facing = 1; break;
+	case 3: y++; facing = 0; break;
+	case 4: x--; facing = 3; break;
+	case 5: x++; facing = 2; break;
+	}
+}
+
+bool WarehouseSim::isFrontier(int tile) {
+	if (tileDatabase.getType(tile) != -1) return false;
+
+	// Check for a known walkable tile next to this unknown tile
+	for (int j = 0; j < 4; j++) {
+		int next = tileDatabase.neighbour(tile, j);
+		if (next >= 0 && tileDatabase.getType(next) != -1 && isPassable(tileDatabase.getType(next))) return true;
+	}
+	return false;
+}
+
+void WarehouseSim::updateFrontierField() {
+	if (frontierField.isBuilt()) {
+		frontierField.update(tileDatabase);
+		return;
+	}
+
+	// Unknown tiles next to known floor
+	goals.clear();
+	for (int i = 0; i < tileDatabase.size(); i++) {
+		if (isFrontier(i)) goals.push_back(i);
+	}
+	frontierField.build(tileDatabase, goals);
+}
+
+void WarehouseSim::updateExitField() {
+	if (exitField.isBuilt()) {
+		exitField.update(tileDatabase);
+		return;
+	}
+
+	// Known exits
+	goals.clear();
+	for (int i = 0; i < tileDatabase.size(); i++) {
+		if (tileDatabase.getType(i) == 8) goals.push_back(i);
+	}
+	exitField.build(tileDatabase, goals);
+}
+
+bool WarehouseSim::closerToGoal(int j, int i, DistanceField* goalField, float goalX, float goalY) {
+	if (goalField != nullptr) {
+		int stepsJ = goalField->distanceAt(robots[j]->getTile());
+		return stepsJ != DistanceField::UNREACHABLE && stepsJ < goalField->distanceAt(robots[i]->getTile());
+	}
+	else return std::sqrt(pow(goalX - robots[j]->getBox().x, 2) + pow(goalY - robots[j]->getBox().y, 2)) < std::sqrt(pow(goalX - robots[i]->getBox().x, 2) + pow(goalY - robots[i]->getBox().y, 2));
+}
+
+void WarehouseSim::processRobot(int i) {
+	RobotDecision decision;
+	uint64_t time = profiler.now();
+	decideRobot(i, decision);
+	profiler.lap(PHASE_DECIDE, time);
+	actRobot(i, decision);
+}
+
+void WarehouseSim::decideRobot(int i, RobotDecision& decision) {
+	decision = RobotDecision();
+	decision.alive = robots[i]->getBattery() > 0;
+	if (decision.alive) {
+		float goalX = robots[i]->getBox().x;
+		float goalY = robots[i]->getBox().y;
+		double distance = std::numeric_limits<double>::infinity();
+		DistanceField* goalField = nullptr; // Set when following a path instead of heading straight for the goal
+		int takeDir = -1;
+		bool findShelf = false;
+		bool explore = false;
+		bool findExit = false;
+		bool takeItemFromShelf = false;
+		bool waitingForCharger = false;
+		bool chargeBattery = false;
+		bool submit = false;
+		bool passItemAway = false;
+		int recipientRobot = 0;
+		int recipientSpace = 0;
+		int passDir = 0;
+
+		int rescueRobot = -1;
+		if (!robotsToRescue[i].empty()) rescueRobot = *robotsToRescue[i].begin();
+		bool takeRobotItems = false;
+
+		if (receivingItem[i]) {
+			receivingItem[i] = false;
+		}
+		else {
+			// Charge until 100 if already charging
+			if (tileDatabase.contains(robots[i]->getTile())) {
+				if (tileDatabase.getType(robots[i]->getTile()) == 6 && robots[i]->getBattery() < 100) chargeBattery = true;
+			}
+			if (!chargeBattery) {
+				// If robot is low on battery
+				if (robots[i]->getBattery() < 50 || !chargerKnown) {
+					updateChargerField();
+
+					// If standing on a charger, charge
+					if (tileDatabase.getType(robots[i]->getTile()) == 6) chargeBattery = true;
+					// Follow the path to the closest free battery charger
+					else if (chargerField.distanceAt(robots[i]->getTile()) != DistanceField::UNREACHABLE) {
+						goalField = &chargerField;
+
+						if (currentGoal[i] != 2) {
+							currentGoal[i] = 2;
+							robots[i]->resetHistory();
+						}
+					}
+					// Wait for a charger to be free
+					else if (chargerKnown) {
+						waitingForCharger = true;
+						robots[i]->resetHistory();
+					}
+					// If no known chargers, explore to look for one
+					else explore = true;
+				}
+				// If robot is assigned to rescue a dead robot and has no items in hand
+				else if (rescueRobot >= 0 && robots[i]->getWeight() == 0) {
+					goalX = robots[rescueRobot]->getBox().x;
+					goalY = robots[rescueRobot]->getBox().y;
+				
+					if (robots[i]->getBox().x == robots[rescueRobot]->getBox().x) {
+						// If above dead robot
+						if (robots[i]->getBox().y == robots[rescueRobot]->getBox().y - WH) {
+							takeRobotItems = true;
+							takeDir = 1;
+						}
+						// If below dead robot
+						else if (robots[i]->getBox().y == robots[rescueRobot]->getBox().y + WH) {
+							takeRobotItems = true;
+							takeDir = 0;
+						}
+					}
+					else if (robots[i]->getBox().y == robots[rescueRobot]->getBox().y) {
+						// If to the left of dead robot
+						if (robots[i]->getBox().x == robots[rescueRobot]->getBox().x - WH) {
+							takeRobotItems = true;
+							takeDir = 3;
+						}
+						// If to the right of dead robot
+						else if (robots[i]->getBox().x == robots[rescueRobot]->getBox().x + WH) {
+							takeRobotItems = true;
+							takeDir = 2;
+						}
+					}
+
+					if (currentGoal[i] != 4) {
+						currentGoal[i] = 4;
+						robots[i]->resetHistory();
+					}
+				}
+				// If robot still has space for an item
+				else if (robots[i]->getWeight() + orders.getLightestPending() <= MAX_WEIGHT) {
+					// Look for the closest known shelf with an item that no robot has taken yet and that the robot has space for
+					int robotX = robots[i]->getTile() % tileDatabase.getWidth();
+					int robotY = robots[i]->getTile() / tileDatabase.getWidth();
+					int closestShelf = orders.getPendingShelves().nearest(robotX, robotY, [&](int shelf) {
+						return robots[i]->getWeight() + tileDatabase.getWeight(shelf) <= MAX_WEIGHT;
+					});
+					if (closestShelf >= 0) {
+						int shelfX = 0;
+						int shelfY = 0;
+						shelfAccessOf(closestShelf, shelfX, shelfY, takeDir);
+
+						goalX = (float)(shelfX * WH);
+						goalY = (float)(shelfY * WH);
+						distance = std::sqrt(pow(goalX - robots[i]->getBox().x, 2) + pow(goalY - robots[i]->getBox().y, 2));
+						findShelf = true;
+					}
+					// Take the item if already at the shelf
+					if (findShelf && distance == 0) takeItemFromShelf = true;
+
+					// If no known shelf with a wanted item exists, explore
+					if (!findShelf) explore = true;
+					else if (currentGoal[i] != 1) {
+						currentGoal[i] = 1;
+						robots[i]->resetHistory();
+					}
+				}
+				else {
+					updateExitField();
+
+					// If standing on an exit, submit items
+					if (tileDatabase.getType(robots[i]->getTile()) == 8) {
+						findExit = true;
+						if (robots[i]->getWeight() > 0) submit = true;
+					}
+					// Follow the path to the closest exit
+					else if (exitField.distanceAt(robots[i]->getTile()) != DistanceField::UNREACHABLE) {
+						findExit = true;
+						goalField = &exitField;
+					}
+					// If no known exit in database, explore
+					if (!findExit) explore = true;
+					else if (currentGoal[i] != 3) {
+						currentGoal[i] = 3;
+						robots[i]->resetHistory();
+					}
+				}
+			}
+		}
+		// Exploration
+		if (explore) {
+			updateFrontierField();
+
+			// Follow the path to the closest unknown tile next to known floor
+			if (frontierField.distanceAt(robots[i]->getTile()) != DistanceField::UNREACHABLE) goalField = &frontierField;
+			// If there is none, look for the nearest unknown tile
+			else {
+				int closestUnknown = unknownTiles.nearest(robots[i]->getTile() % tiles.getWidth(), robots[i]->getTile() / tiles.getWidth(), [](int) { return true; });
+				if (closestUnknown >= 0) {
+					goalX = tiles.getX(closestUnknown);
+					goalY = tiles.getY(closestUnknown);
+					distance = std::sqrt(pow(goalX - robots[i]->getBox().x, 2) + pow(goalY - robots[i]->getBox().y, 2));
+				}
+			}
+
+			if (currentGoal[i] != 0) {
+				currentGoal[i] = 0;
+				robots[i]->resetHistory();
+			}
+		}
+
+		// Calculate f(n) = g(n) + h(n)
+		double f[4] = { 0 };
+
+		// where g(n) = visit history
+		int currentTile = robots[i]->getTile();
+		int historyWeight = 100;
+
+		f[0] += (double)(historyWeight * robots[i]->getHistory(settings, currentTile - settings.mapWidth / WH));
+		f[1] += (double)(historyWeight * robots[i]->getHistory(settings, currentTile + settings.mapWidth / WH));
+		f[2] += (double)(historyWeight * robots[i]->getHistory(settings, currentTile - 1));
+		f[3] += (double)(historyWeight * robots[i]->getHistory(settings, currentTile + 1));
+
+		// h(n) = path length to goal if following a path
+		if (goalField != nullptr) {
+			for (int j = 0; j < 4; j++) {
+				int steps = goalField->distanceAt(tileDatabase.neighbour(currentTile, j));
+				if (steps == DistanceField::UNREACHABLE) f[j] = std::numeric_limits<double>::infinity();
+				else f[j] += (double)(WH * steps);
+			}
+		}
+		// else Euclidean distance from goal
+		else {
+			f[0] -= std::sqrt(pow(goalX - robots[i]->getBox().x, 2) + pow(goalY - robots[i]->getBox().y - WH, 2)); // Up
+			f[1] -= std::sqrt(pow(goalX - robots[i]->getBox().x, 2) + pow(goalY - robots[i]->getBox().y + WH, 2)); // Down
+			f[2] -= std::sqrt(pow(goalX - robots[i]->getBox().x - WH, 2) + pow(goalY - robots[i]->getBox().y, 2)); // Left
+			f[3] -= std::sqrt(pow(goalX - robots[i]->getBox().x + WH, 2) + pow(goalY - robots[i]->getBox().y, 2)); // Right
+		}
+
+		// Check that robot is not moving to a blocked tile or off the edge of the map
+		for (int j = 0; j < 4; j++) {
+			int next = tileDatabase.neighbour(currentTile, j);
+			if (next < 0 || !isPassable(tileDatabase.getType(next))) f[j] = std::numeric_limits<double>::infinity();
+		}
+
+		// Choose minimum f(n)
+		int bestAction = 0;
+		for (int j = 1; j < 4; j++) {
+			if (f[j] < f[bestAction]) {
+				bestAction = j;
+			}
+		}
+
+		// Check that that movement is not blocked by a robot
+		// If blocked and finding exit, pass item to that robot
+		int itemToPass = 0;
+		// Go through neighbouring robots in index order, as finding one to pass to ends the check
+		// Each one is inserted in order as it is found, as there are at most 4
+		int neighbours[4];
+		int numberOfNeighbours = 0;
+		for (int j = 0; j < 4; j++) {
+			int neighbour = robotGrid.robotAt(neighbourTile(settings, currentTile, j));
+			if (neighbour < 0 || robots[neighbour] == nullptr) continue;
+
+			int position = numberOfNeighbours++;
+			while (position > 0 && neighbours[position - 1] > neighbour) {
+				neighbours[position] = neighbours[position - 1];
+				position--;
+			}
+			neighbours[position] = neighbour;
+		}
+		for (int n = 0; n < numberOfNeighbours; n++) {
+			int j = neighbours[n];
+			if (robots[j]->getBox().x == robots[i]->getBox().x) {
+				if (robots[j]->getBox().y == robots[i]->getBox().y - WH) {
+					f[0] = std::numeric_limits<double>::infinity();
+
+					if (robots[j]->getBattery() > 0 && findExit && bestAction == 0 && robots[j]->getWeight() < MAX_WEIGHT && closerToGoal(j, i, goalField, goalX, goalY)) {
+						recipientSpace = MAX_WEIGHT - robots[recipientRobot]->getWeight();
+
+						// Find largest item that can be passed
+						for (int k = 0; k < MAX_WEIGHT; k++) {
+							if (weightOf(robots[i]->getItem(k)) > weightOf(itemToPass) && weightOf(robots[i]->getItem(k)) <= recipientSpace) itemToPass = robots[i]->getItem(k);
+						}
+
+						if (itemToPass > 0) {
+							passItemAway = true;
+							recipientRobot = j;
+							passDir = 0;
+							break;
+						}
+					}
+				}
+				else if (robots[j]->getBox().y == robots[i]->getBox().y + WH) {
+					f[1] = std::numeric_limits<double>::infinity();
+
+					if (robots[j]->getBattery() > 0 && findExit && bestAction == 1 && robots[j]->getWeight() < MAX_WEIGHT && closerToGoal(j, i, goalField, goalX, goalY)) {
+						recipientSpace = MAX_WEIGHT - robots[recipientRobot]->getWeight();
+
+						// Find largest item that can be passed
+						for (int k = 0; k < MAX_WEIGHT; k++) {
+							if (weightOf(robots[i]->getItem(k)) > weightOf(itemToPass) && weightOf(robots[i]->getItem(k)) <= recipientSpace) itemToPass = robots[i]->getItem(k);
+						}
+
+						if (itemToPass > 0) {
+							passItemAway = true;
+							recipientRobot = j;
+							passDir = 1;
+							break;
+						}
+					}
+				}
+			}
+			else if (robots[j]->getBox().y == robots[i]->getBox().y) {
+				if (robots[j]->getBox().x == robots[i]->getBox().x - WH) {
+					f[2] = std::numeric_limits<double>::infinity();
+
+					if (robots[j]->getBattery() > 0 && findExit && bestAction == 2 && robots[j]->getWeight() < MAX_WEIGHT && closerToGoal(j, i, goalField, goalX, goalY)) {
+						recipientSpace = MAX_WEIGHT - robots[recipientRobot]->getWeight();
+
+						// Find largest item that can be passed
+						for (int k = 0; k < MAX_WEIGHT; k++) {
+							if (weightOf(robots[i]->getItem(k)) > weightOf(itemToPass) && weightOf(robots[i]->getItem(k)) <= recipientSpace) itemToPass = robots[i]->getItem(k);
+						}
+
+						if (itemToPass > 0) {
+							passItemAway = true;
+							recipientRobot = j;
+							passDir = 2;
+							break;
+						}
+					}
+				}
+				else if (robots[j]->getBox().x == robots[i]->getBox().x + WH) {
+					f[3] = std::numeric_limits<double>::infinity();
+
+					if (robots[j]->getBattery() > 0 && findExit && bestAction == 3 && robots[j]->getWeight() < MAX_WEIGHT && closerToGoal(j, i, goalField, goalX, goalY)) {
+						recipientSpace = MAX_WEIGHT - robots[recipientRobot]->getWeight();
+
+						// Find largest item that can be passed
+						for (int k = 0; k < MAX_WEIGHT; k++) {
+							if (weightOf(robots[i]->getItem(k)) > weightOf(itemToPass) && weightOf(robots[i]->getItem(k)) <= recipientSpace) itemToPass = robots[i]->getItem(k);
+						}
+
+						if (itemToPass > 0) {
+							passItemAway = true;
+							recipientRobot = j;
+							passDir = 3;
+							break;
+						}
+					}
+				}
+			}
+		}
+
+		// Choose minimum f(n)
+		bestAction = 0;
+		for (int j = 1; j < 4; j++) {
+			if (f[j] < f[bestAction]) {
+				bestAction = j;
+			}
+		}
+
+		decision.waitingForCharger = waitingForCharger;
+		decision.submit = submit;
+		decision.chargeBattery = chargeBattery;
+		decision.takeRobotItems = takeRobotItems;
+		decision.takeItemFromShelf = takeItemFromShelf;
+		decision.passItemAway = passItemAway;
+		decision.takeDir = takeDir;
+		decision.passDir = passDir;
+		decision.itemToPass = itemToPass;
+		decision.recipientRobot = recipientRobot;
+		decision.bestAction = bestAction;
+	}
+	// If robot battery is <= 0 and has items on it
+	else if (robots[i]->getWeight() > 0) {
+		// Find closest surviving robot with sufficient battery and no items on hand
+		decision.rescuer = idleRobots.nearest(robots[i]->getTile() % tiles.getWidth(), robots[i]->getTile() / tiles.getWidth(), [](int) { return true; });
+	}
+	else decision.rescuer = 0;
+}
+
+void WarehouseSim::actRobot(int i, const RobotDecision& decision) {
+	// Dead robots only change which robot is to rescue them
+	if (!decision.alive) {
+		if (decision.rescuer >= 0) setRescuer(i, decision.rescuer);
+		return;
+	}
+
+	uint64_t time = profiler.now();
+
+	// Carry out the action
+	// If waiting for charger, stay still
+	// If receiving item, stay still
+	if (!decision.waitingForCharger && !receivingItem[i]) {
+		// Actions that succeed are added to the trace
+		if (decision.submit) {
+			if (robots[i]->submitItems(tileDatabase, orders)) trace.submitItems(i);
+		}
+		else if (decision.chargeBattery) {
+			if (robots[i]->charge(tileDatabase)) trace.charge(i);
+		}
+		else if (decision.takeRobotItems) {
+			// Turn to dead robot if not already facing it
+			if (robots[i]->getDir() != decision.takeDir) {
+				if (robots[i]->turn(decision.takeDir)) trace.turn(i, decision.takeDir);
+			}
+			// Take item from dead robot
+			else if (robots[i]->takeRobotItem(settings, robots.data(), robotGrid)) trace.takeRobotItems(i);
+		}
+		else if (decision.takeItemFromShelf) {
+			// Turn to shelf if not already facing it
+			if (robots[i]->getDir() != decision.takeDir) {
+				if (robots[i]->turn(decision.takeDir)) trace.turn(i, decision.takeDir);
+			}
+			// Take item from shelf
+			else if (robots[i]->takeShelfItem(settings, tiles, orders)) trace.takeShelfItem(i);
+		}
+		else if (decision.passItemAway) {
+			if (robots[i]->getDir() != decision.passDir) {
+				if (robots[i]->turn(decision.passDir)) trace.turn(i, decision.passDir);
+			}
+			// In a two-phase tick the recipient may have moved away since the decision
+			else if (robotGrid.robotAt(neighbourTile(settings, robots[i]->getTile(), decision.passDir)) == decision.recipientRobot) {
+				if (robots[i]->passItem(settings, robots.data(), robotGrid, tileDatabase, decision.itemToPass)) trace.passItem(i, decision.itemToPass);
+				updateIdle(decision.recipientRobot);
+				receivingItem[decision.recipientRobot] = true;
+			}
+		}
+		// Turn to direction if not already facing it
+		else if (robots[i]->getDir() != decision.bestAction) {
+			if (robots[i]->turn(decision.bestAction)) trace.turn(i, decision.bestAction);
+		}
+		// Move
+		else {
+			int fromTile = robots[i]->getTile();
+
+			profiler.count(COUNTER_COLLISION_CHECKS);
+			if (!robots[i]->move(settings, tiles, robotGrid)) profiler.count(COUNTER_MOVES_BLOCKED);
+			else {
+				trace.move(i);
+
+				// Obstacles can be placed on the floor tile left behind, but not under the robot
+				if (tiles.getType(fromTile) == 1) freeFloor.insert(fromTile);
+				freeFloor.remove(robots[i]->getTile());
+
+				// Robots moving on or off a known charger change which chargers are free
+				if (tileDatabase.getType(fromTile) == 6) chargerField.setGoal(fromTile, true);
+				if (tileDatabase.getType(robots[i]->getTile()) == 6) chargerField.setGoal(robots[i]->getTile(), false);
+			}
+		}
+	}
+
+	time = profiler.lap(PHASE_MOVE, time);
+
+	changedTiles.clear();
+	profiler.count(COUNTER_TILES_SCANNED, robots[i]->sight(settings, tiles, tileDatabase, changedTiles));
+	profiler.count(COUNTER_TILES_DISCOVERED, changedTiles.size());
+	trace.sight(i, robots[i]->getTile(), changedTiles);
+	for (int j = 0; j < (int)changedTiles.size(); j++) {
+		int changedTile = changedTiles[j];
+		if (tileDatabase.getType(changedTile) != -1) unknownTiles.remove(changedTile);
+
+		// Add newly discovered shelves to the order index
+		if (tileDatabase.getType(changedTile) >= 2 && tileDatabase.getType(changedTile) <= 5) {
+			int shelfX = 0;
+			int shelfY = 0;
+			int facing = 0;
+			shelfAccessOf(changedTile, shelfX, shelfY, facing);
+			orders.addShelf(tileDatabase.getItem(changedTile), changedTile, shelfX, shelfY);
+		}
+
+		// Repair paths around the tile, and add newly discovered chargers and exits as goals
+		chargerField.tileChanged(changedTile);
+		exitField.tileChanged(changedTile);
+		if (tileDatabase.getType(changedTile) == 6) {
+			chargerKnown = true;
+			chargerField.setGoal(changedTile, robotGrid.robotAt(changedTile) < 0);
+		}
+		if (tileDatabase.getType(changedTile) == 8) exitField.setGoal(changedTile, true);
+
+		// The tile and its neighbours may have joined or left the frontier
+		frontierField.tileChanged(changedTile);
+		frontierField.setGoal(changedTile, isFrontier(changedTile));
+		for (int k = 0; k < 4; k++) {
+			int next = tileDatabase.neighbour(changedTile, k);
+			if (next >= 0) frontierField.setGoal(next, isFrontier(next));
+		}
+	}
+	time = profiler.lap(PHASE_SIGHT, time);
+
+	robots[i]->updateHistory(tileDatabase);
+	time = profiler.lap(PHASE_HISTORY, time);
+
+	// Check if all items have been successfully retrieved
+	if (getItemsRetrieved() == settings.numberItems) {
+		// End the simulation
+		completed = true;
+		finished = true;
+	}
+
+	// Count dead robots; only this robot's battery can have run out this turn
+	if (robots[i]->getBattery() <= 0) numDeadRobots++;
+
+	// Check if run is doomed to fail or told to skip
+	if (numDeadRobots > 0.5 * settings.numberRobots || skipRequested || (settings.maxTicks > 0 && ticks > settings.maxTicks)) {
+		// End the simulation
+		if (!failed) {
+			if (numDeadRobots > 0.5 * settings.numberRobots) failureReason = "dead robots";
+			else if (skipRequested) failureReason = "skipped";
+			else failureReason = "tick limit";
+		}
+		failed = true;
+		finished = true;
+	}
+	profiler.lap(PHASE_CHECKS, time);
+}
+
+void WarehouseSim::updateIdle(int robot) {
+	if (robots[robot]->getBattery() >= 50 && robots[robot]->getWeight() == 0) idleRobots.insert(robot, robots[robot]->getTile() % tiles.getWidth(), robots[robot]->getTile() / tiles.getWidth());
+	else idleRobots.remove(robot);
+}
+
+void WarehouseSim::setRescuer(int deadRobotIndex, int rescuer) {
+	if (deadRobot[deadRobotIndex] == rescuer) return;
+
+	if (deadRobot[deadRobotIndex] >= 0) robotsToRescue[deadRobot[deadRobotIndex]].erase(deadRobotIndex);
+	deadRobot[deadRobotIndex] = rescuer;
+	robotsToRescue[rescuer].insert(deadRobotIndex);
+}
@@ -0,0 +1,1635 @@
+#pragma once
+#include "EventTrace.h"
+#include "SimRandom.h"
+#include "Snapshot.h"
+#include "TickProfiler.h"
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+// Number of iterations for each combination of settings when testing
+constexpr int TEST_ITERATIONS = 10;
+// Iterations of adaptive tests: at least MIN_TEST_ITERATIONS, then more until the 95% confidence interval of the ticks per item is within TEST_PRECISION of its mean, up to MAX_TEST_ITERATIONS
+constexpr int MIN_TEST_ITERATIONS = 5;
+constexpr int MAX_TEST_ITERATIONS = 50;
+constexpr double TEST_PRECISION = 0.1;
+// Adaptive tests also stop once the runs show with 95% confidence that fewer than this share of runs complete
+constexpr double TEST_MIN_COMPLETION = 0.5;
+
+// Tile width and height
+constexpr int WH = 16;
+// Number of tile sprites
+constexpr int TILE_SPRITES = 9;
+
+// Number of items to be retrieved
+constexpr int MAX_ITEMS_RETRIEVE = 100;
+
+// Maximum number of robots in the menu and in tests
+constexpr int MAX_ROBOTS = 100;
+// Maximum number of robots in a single simulation
+constexpr int MAX_FLEET = 10000;
+// Robot battery loss per tick of movement
+constexpr float BATTERY_LOSS = (float)0.2;
+// Robot battery gain per tick of charging
+constexpr float BATTERY_GAIN = 5;
+// Maximum weight of items that a robot can carry at once
+constexpr int MAX_WEIGHT = 10;
+
+// Obstacle-generating cooldown in number of ticks
+constexpr int OBSTACLE_CD = 100;
+// Max number of obstacles at a time
+constexpr int MAX_OBSTACLES = 100;
+
+// Number of ticks in each point of the throughput series
+constexpr int THROUGHPUT_TICKS = 100;
+
+// Settings of a single simulation
+struct SimSettings {
+	int mapNumber = 1;
+	std::string mapPath = "warehouse_resources/map1.map";
+	int mapWidth = 50 * WH; // Width and height of the map; replaced by the size in the map file when the map is loaded
+	int mapHeight = 50 * WH;
+	int numberRobots = MAX_ROBOTS;
+	int numberObstacles = MAX_OBSTACLES;
+	int numberItems = MAX_ITEMS_RETRIEVE;
+	int maxTicks = 0; // Fail the simulation once it takes more than this many ticks (0 for no limit)
+	bool twoPhaseTicks = false; // Decide every robot's action in parallel, then carry the actions out in a shuffled order
+	int tickThreads = 0; // Threads deciding actions in two-phase ticks (0 for one per core)
+	bool profile = false; // Time the phases of every tick and count operations
+	bool recordThroughput = false; // Record the items retrieved in every THROUGHPUT_TICKS ticks
+	bool recordTrace = false; // Record every robot's actions in an event trace, for replaying the simulation
+};
+
+// Index of the tile at map coordinates (x, y); tiles are stored row by row
+inline int tileIndex(const SimSettings& settings, float x, float y) {
+	return (int)y / WH * (settings.mapWidth / WH) + (int)x / WH;
+}
+
+// Index of the tile next to a tile in a direction (0: up, 1: down, 2: left, 3: right); -1 if outside the map
+inline int neighbourTile(const SimSettings& settings, int tile, int direction) {
+	int mapWidth = settings.mapWidth / WH;
+	int mapHeight = settings.mapHeight / WH;
+
+	switch (direction) {
+	case 0: return tile >= mapWidth ? tile - mapWidth : -1;
+	case 1: return tile + mapWidth < mapWidth * mapHeight ? tile + mapWidth : -1;
+	case 2: return tile % mapWidth > 0 ? tile - 1 : -1;
+	case 3: return tile % mapWidth < mapWidth - 1 ? tile + 1 : -1;
+	}
+	return -1;
+}
+
+// Rectangle in map coordinates
+struct Box {
+	float x, y, w, h;
+};
+
+// Tiles of a map, stored row by row with one array per tile property
+class TileGrid {
+public:
+	// Sets up a map of unknown tiles
+	void reset(int setWidth, int setHeight) {
+		width = setWidth;
+		height = setHeight;
+
+		type.assign(width * height, 0);
+		item.assign(width * height, -1);
+		weight.assign(width * height, -1);
+		known.assign(width * height, 0);
+	}
+
+	// Get functions
+	int getWidth() const {
+		return width;
+	}
+	int getHeight() const {
+		return height;
+	}
+	int size() const {
+		return width * height;
+	}
+	// Check that an index is a tile on the map
+	bool contains(int index) const {
+		return index >= 0 && index < width * height;
+	}
+	// Index of the tile next to a tile in a direction (0: up, 1: down, 2: left, 3: right); -1 if outside the map
+	int neighbour(int index, int direction) const {
+		switch (direction) {
+		case 0: return index >= width ? index - width : -1;
+		case 1: return index + width < width * height ? index + width : -1;
+		case 2: return index % width > 0 ? index - 1 : -1;
+		case 3: return index % width < width - 1 ? index + 1 : -1;
+		}
+		return -1;
+	}
+	float getX(int index) const {
+		return (float)(index % width * WH);
+	}
+	float getY(int index) const {
+		return (float)(index / width * WH);
+	}
+	int getType(int index) const {
+		if (known[index]) return type[index];
+		else return -1;
+	}
+	int getItem(int index) const {
+		return item[index];
+	}
+	int getWeight(int index) const {
+		return weight[index];
+	}
+
+	// Set functions
+	void setTile(int index, int setType, int setItem = -1, int setWeight = -1) {
+		setTileType(index, setType);
+
+		if (setType >= 2 && setType <= 5) {
+			item[index] = setItem;
+			weight[index] = (int8_t)setWeight;
+		}
+		else {
+			item[index] = -1;
+			weight[index] = -1;
+		}
+	}
+	void setTileType(int index, int setType) {
+		if (setType >= 0) {
+			type[index] = (uint8_t)setType;
+			known[index] = 1;
+		}
+		else known[index] = 0;
+	}
+	void setItem(int index, int setShelfItem) {
+		item[index] = setShelfItem;
+	}
+	void setWeight(int index, int setShelfWeight) {
+		weight[index] = (int8_t)setShelfWeight;
+	}
+
+	// Copy a tile from another map of the same size; returns true if the tile changed
+	bool record(const TileGrid& from, int index) {
+		bool changed = type[index] != from.type[index] || known[index] != from.known[index] || item[index] != from.item[index] || weight[index] != from.weight[index];
+
+		type[index] = from.type[index];
+		known[index] = from.known[index];
+		item[index] = from.item[index];
+		weight[index] = from.weight[index];
+		return changed;
+	}
+	// Write the grid into a snapshot, or read it back
+	void save(SnapshotWriter& out) const {
+		out.write(width);
+		out.write(height);
+		out.write(type);
+		out.write(item);
+		out.write(weight);
+		out.write(known);
+	}
+	void load(SnapshotReader& in) {
+		in.read(width);
+		in.read(height);
+		in.read(type);
+		in.read(item);
+		in.read(weight);
+		in.read(known);
+	}
+	// Write the grid with one byte per tile and the items of shelves only, or read it back; no other tile holds an item
+	void saveCompact(SnapshotWriter& out) const {
+		std::vector<uint8_t> codes(type.size());
+		std::vector<int> shelfItems;
+		for (size_t i = 0; i < type.size(); i++) {
+			codes[i] = known[i] ? type[i] + 1 : 0;
+			if (type[i] >= 2 && type[i] <= 5) {
+				shelfItems.push_back(item[i]);
+				shelfItems.push_back(weight[i]);
+			}
+		}
+		out.write(width);
+		out.write(height);
+		out.write(codes);
+		out.write(shelfItems);
+	}
+	void loadCompact(SnapshotReader& in) {
+		std::vector<uint8_t> codes;
+		std::vector<int> shelfItems;
+		in.read(width);
+		in.read(height);
+		in.read(codes);
+		in.read(shelfItems);
+		if (width < 0 || height < 0 || (int64_t)width * height != (int64_t)codes.size()) {
+			in.fail();
+			return;
+		}
+
+		reset(width, height);
+		size_t nextItem = 0;
+		for (int i = 0; i < size(); i++) {
+			type[i] = codes[i] > 0 ? codes[i] - 1 : 0;
+			known[i] = codes[i] > 0;
+			if (type[i] >= 2 && type[i] <= 5) {
+				if (nextItem + 2 > shelfItems.size()) {
+					in.fail();
+					return;
+				}
+				item[i] = shelfItems[nextItem++];
+				weight[i] = (int8_t)shelfItems[nextItem++];
+			}
+		}
+	}
+private:
+	int width = 0;
+	int height = 0;
+	std::vector<uint8_t> type;
+	std::vector<int> item;		// Item held by shelves; -1 if no item or not a shelf
+	std::vector<int8_t> weight; // The weight of the item
+	std::vector<uint8_t> known; // 0 if the tile type is unknown (-1)
+};
+
+// Check if robots can plan a path through a tile type; unknown tiles are assumed to be walkable
+inline bool isPassable(int type) {
+	return type == -1 || type == 1 || (type >= 6 && type <= 8);
+}
+
+// Number of steps from every tile to the closest goal tile along the known map
+// All robots going to the same kind of goal share one field. After it is first built, only the distances around changed tiles are repaired
+class DistanceField {
+public:
+	// Distance of a tile that has no known path to any goal
+	static constexpr int UNREACHABLE = -1;
+
+	// Calculates the whole field with a breadth-first search from all goal tiles at once
+	void build(const TileGrid& known, const std::vector<int>& goals);
+	bool isBuilt() const {
+		return !distance.empty();
+	}
+
+	// A known tile changed and may have become blocked or walkable
+	void tileChanged(int tile) {
+		if (isBuilt()) addPending(tile);
+	}
+	// Add or remove a goal tile
+	void setGoal(int tile, bool isGoal) {
+		if (isBuilt() && goal[tile] != (uint8_t)isGoal) {
+			goal[tile] = (uint8_t)isGoal;
+			addPending(tile);
+		}
+	}
+	// Repairs the distances affected by the tiles and goals changed since the last update
+	void update(const TileGrid& known);
+
+	// Steps from a tile to the closest goal; UNREACHABLE if there is none
+	int distanceAt(int tile) const {
+		if (tile >= 0 && tile < (int)distance.size()) return distance[tile];
+		else return UNREACHABLE;
+	}
+	bool hasGoals() const {
+		return numberOfGoals > 0;
+	}
+	void save(SnapshotWriter& out) const {
+		out.write(distance);
+		out.write(open);
+		out.write(goal);
+		out.write(isPending);
+		out.write(raised);
+		out.write(pending);
+		out.write(queue);
+		out.write(numberOfGoals);
+	}
+	void load(SnapshotReader& in) {
+		in.read(distance);
+		in.read(open);
+		in.read(goal);
+		in.read(isPending);
+		in.read(raised);
+		in.read(pending);
+		in.read(queue);
+		in.read(numberOfGoals);
+	}
+private:
+	void addPending(int tile) {
+		if (!isPending[tile]) {
+			isPending[tile] = 1;
+			pending.push_back(tile);
+		}
+	}
+	// Shortest distance to a tile through its neighbours; UNREACHABLE if no neighbour has a path
+	int distanceThroughNeighbours(const TileGrid& known, int tile) const;
+
+	std::vector<int> distance;
+	std::vector<uint8_t> open;		// Whether each tile was walkable when its distance was last worked out
+	std::vector<uint8_t> goal;		// Whether each tile is a goal (only counted while walkable)
+	std::vector<uint8_t> isPending;
+	std::vector<uint8_t> raised;	// Tiles whose distance was lost during an update (2 once spread from)
+	std::vector<int> pending;		// Tiles changed since the last update
+	std::vector<int> queue;			// Tiles to search from, or tiles that lost their distance during an update
+	int numberOfGoals = 0;
+};
+
+// Which robot is standing on each tile, so robots next to a tile can be found without checking every robot
+class RobotGrid {
+public:
+	// Sets up a map with no robots
+	void reset(int numberOfTiles) {
+		occupant.assign(numberOfTiles, -1);
+	}
+
+	// Index of the robot on a tile; -1 if there is none or the tile is outside the map
+	int robotAt(int tile) {
+		if (tile >= 0 && tile < (int)occupant.size()) return occupant[tile];
+		else return -1;
+	}
+
+	void place(int robot, int tile) {
+		occupant[tile] = robot;
+	}
+	void moveRobot(int fromTile, int toTile) {
+		occupant[toTile] = occupant[fromTile];
+		occupant[fromTile] = -1;
+	}
+	void save(SnapshotWriter& out) const {
+		out.write(occupant);
+	}
+	void load(SnapshotReader& in) {
+		in.read(occupant);
+	}
+private:
+	std::vector<int> occupant; // Index of the robot on each tile; -1 if empty
+};
+
+// Set of tiles that can be added, removed and drawn at random in constant time
+class TileSampler {
+public:
+	// Sets up an empty set for tiles from 0 to numberOfTiles - 1
+	void reset(int numberOfTiles) {
+		cells.clear();
+		slot.assign(numberOfTiles, -1);
+	}
+
+	void insert(int tile) {
+		if (slot[tile] >= 0) return;
+		slot[tile] = (int)cells.size();
+		cells.push_back(tile);
+	}
+	void remove(int tile) {
+		if (slot[tile] < 0) return;
+
+		// Move the last tile into the removed tile's slot
+		int last = cells.back();
+		cells[slot[tile]] = last;
+		slot[last] = slot[tile];
+		cells.pop_back();
+		slot[tile] = -1;
+	}
+	bool contains(int tile) const {
+		return slot[tile] >= 0;
+	}
+	int size() const {
+		return (int)cells.size();
+	}
+	// A tile drawn uniformly at random; the set must not be empty
+	int sample(SimRandom& random) const {
+		return cells[random.nextInt((int)cells.size())];
+	}
+	void save(SnapshotWriter& out) const {
+		out.write(cells);
+		out.write(slot);
+	}
+	void load(SnapshotReader& in) {
+		in.read(cells);
+		in.read(slot);
+	}
+private:
+	std::vector<int> cells;
+	std::vector<int> slot; // Position of each tile in cells; -1 if the tile is not in the set
+};
+
+// Points on the map sorted into square buckets of tiles, for finding the closest points to a position
+// Each point has an id (such as a robot index or a tile) and a position in tiles
+class PointIndex {
+public:
+	// Sets up an empty index for a map of width by height tiles and ids from 0 to numberOfIds - 1
+	void reset(int setWidth, int setHeight, int numberOfIds, int setBucketSize = 8) {
+		bucketSize = setBucketSize;
+		bucketsX = (setWidth + bucketSize - 1) / bucketSize;
+		bucketsY = (setHeight + bucketSize - 1) / bucketSize;
+		if (bucketsX < 1) bucketsX = 1;
+		if (bucketsY < 1) bucketsY = 1;
+
+		buckets.assign(bucketsX * bucketsY, std::vector<int>());
+		pointX.assign(numberOfIds, 0);
+		pointY.assign(numberOfIds, 0);
+		bucketOf.assign(numberOfIds, -1);
+		slot.assign(numberOfIds, -1);
+		points.clear();
+		pointSlot.assign(numberOfIds, -1);
+	}
+
+	// Adds a point, or moves it if it is already in the index
+	void insert(int id, int x, int y) {
+		int bucket = bucketAt(x, y);
+		pointX[id] = x;
+		pointY[id] = y;
+		if (bucketOf[id] == bucket) return;
+
+		remove(id);
+		bucketOf[id] = bucket;
+		slot[id] = (int)buckets[bucket].size();
+		buckets[bucket].push_back(id);
+		pointSlot[id] = (int)points.size();
+		points.push_back(id);
+	}
+	void remove(int id) {
+		if (!contains(id)) return;
+
+		// Swap the last point in the bucket and in the list into this point's place
+		std::vector<int>& bucket = buckets[bucketOf[id]];
+		int last = bucket.back();
+		bucket[slot[id]] = last;
+		slot[last] = slot[id];
+		bucket.pop_back();
+		bucketOf[id] = -1;
+		slot[id] = -1;
+
+		last = points.back();
+		points[pointSlot[id]] = last;
+		pointSlot[last] = pointSlot[id];
+		points.pop_back();
+		pointSlot[id] = -1;
+	}
+
+	// Get functions
+	bool contains(int id) const {
+		return id >= 0 && id < (int)bucketOf.size() && bucketOf[id] >= 0;
+	}
+	int size() const {
+		return (int)points.size();
+	}
+	// Position a point was last given, even if it has since been removed
+	int getX(int id) const {
+		return pointX[id];
+	}
+	int getY(int id) const {
+		return pointY[id];
+	}
+
+	// Closest point to a position that passes a check; -1 if there is none
+	// On a tie, the lower id wins
+	template <typename Check>
+	int nearest(int x, int y, Check accept) const {
+		int closest = -1;
+		nearest(x, y, 1, accept, &closest);
+		return closest;
+	}
+	// Up to k closest points to a position that pass a check, closest first; returns how many were found
+	template <typename Check>
+	int nearest(int x, int y, int k, Check accept, int found[]) const {
+		int numberFound = 0;
+		if (k <= 0) return 0;
+
+		// With fewer points than buckets, checking every point is faster than searching the buckets
+		if ((int)points.size() < bucketsX * bucketsY) {
+			for (int n = 0; n < (int)points.size(); n++) {
+				consider(points[n], x, y, k, accept, found, numberFound);
+			}
+			return numberFound;
+		}
+
+		int centreX = clamp(x / bucketSize, bucketsX);
+		int centreY = clamp(y / bucketSize, bucketsY);
+		int maxRing = std::max(std::max(centreX, bucketsX - 1 - centreX), std::max(centreY, bucketsY - 1 - centreY));
+
+		// Search rings of buckets around the position's bucket
+		for (int ring = 0; ring <= maxRing; ring++) {
+			for (int by = centreY - ring; by <= centreY + ring; by++) {
+				if (by < 0 || by >= bucketsY) continue;
+
+				// Only the edge of the ring is new
+				int step = (by == centreY - ring || by == centreY + ring) ? 1 : std::max(2 * ring, 1);
+				for (int bx = centreX - ring; bx <= centreX + ring; bx += step) {
+					if (bx < 0 || bx >= bucketsX) continue;
+
+					const std::vector<int>& bucket = buckets[by * bucketsX + bx];
+					for (int n = 0; n < (int)bucket.size(); n++) {
+						consider(bucket[n], x, y, k, accept, found, numberFound);
+					}
+				}
+			}
+
+			// Points in later rings are at least ring * bucketSize + 1 tiles away along one axis
+			long long reach = (long long)ring * bucketSize + 1;
+			if (numberFound == k && distanceTo(found[k - 1], x, y) < reach * reach) break;
+		}
+		return numberFound;
+	}
+	void save(SnapshotWriter& out) const {
+		out.write(bucketSize);
+		out.write(bucketsX);
+		out.write(bucketsY);
+		out.write(buckets);
+		out.write(pointX);
+		out.write(pointY);
+		out.write(bucketOf);
+		out.write(slot);
+		out.write(points);
+		out.write(pointSlot);
+	}
+	void load(SnapshotReader& in) {
+		in.read(bucketSize);
+		in.read(bucketsX);
+		in.read(bucketsY);
+		in.read(buckets);
+		in.read(pointX);
+		in.read(pointY);
+		in.read(bucketOf);
+		in.read(slot);
+		in.read(points);
+		in.read(pointSlot);
+	}
+private:
+	// Add a point to the closest points found so far if it is closer than one of them and passes the check
+	template <typename Check>
+	void consider(int id, int x, int y, int k, Check& accept, int found[], int& numberFound) const {
+		long long distance = distanceTo(id, x, y);
+
+		// Skip points that are no closer than the furthest one found so far
+		if (numberFound == k && !closer(distance, id, distanceTo(found[k - 1], x, y), found[k - 1])) return;
+		if (!accept(id)) return;
+
+		// Insert in order of distance
+		int position = numberFound < k ? numberFound++ : k - 1;
+		while (position > 0 && closer(distance, id, distanceTo(found[position - 1], x, y), found[position - 1])) {
+			found[position] = found[position - 1];
+			position--;
+		}
+		found[position] = id;
+	}
+	static int clamp(int value, int count) {
+		if (value < 0) return 0;
+		if (value >= count) return count - 1;
+		return value;
+	}
+	// Squared distance from a point to a position
+	long long distanceTo(int id, int x, int y) const {
+		return (long long)(pointX[id] - x) * (pointX[id] - x) + (long long)(pointY[id] - y) * (pointY[id] - y);
+	}
+	static bool closer(long long distance, int id, long long otherDistance, int otherId) {
+		return distance < otherDistance || (distance == otherDistance && id < otherId);
+	}
+	int bucketAt(int x, int y) const {
+		return clamp(y / bucketSize, bucketsY) * bucketsX + clamp(x / bucketSize, bucketsX);
+	}
+
+	int bucketSize = 8;
+	int bucketsX = 0;
+	int bucketsY = 0;
+	std::vector<std::vector<int>> buckets; // Ids of the points in each bucket
+	std::vector<int> pointX;
+	std::vector<int> pointY;
+	std::vector<int> bucketOf; // Bucket holding each id; -1 if the id is not in the index
+	std::vector<int> slot;	   // Position of each id in its bucket
+	std::vector<int> points;   // Ids of all points in the index
+	std::vector<int> pointSlot; // Position of each id in points
+};
+
+// How many times a robot has visited each tile since its history was last reset
+// Only visited tiles are stored, and a reset starts a new generation instead of clearing them
+class VisitHistory {
+public:
+	int get(int tile) const {
+		if (slots.empty()) return 0;
+
+		for (uint32_t i = slotOf(tile);; i = (i + 1) & (uint32_t)(slots.size() - 1)) {
+			// Slots from older generations are empty
+			if (slots[i].generation != generation) return 0;
+			if (slots[i].tile == tile) return slots[i].count;
+		}
+	}
+	void add(int tile) {
+		// Keep the table at most half full
+		if ((used + 1) * 2 > slots.size()) grow();
+
+		for (uint32_t i = slotOf(tile);; i = (i + 1) & (uint32_t)(slots.size() - 1)) {
+			if (slots[i].generation != generation) {
+				slots[i] = { tile, 1, generation };
+				used++;
+				return;
+			}
+			if (slots[i].tile == tile) {
+				slots[i].count++;
+				return;
+			}
+		}
+	}
+	void reset() {
+		used = 0;
+		generation++;
+
+		// The generation counter wrapped around, so old slots could look current again
+		if (generation == 0) {
+			for (size_t i = 0; i < slots.size(); i++) slots[i].generation = 0;
+			generation = 1;
+		}
+	}
+	void save(SnapshotWriter& out) const {
+		out.write(slots);
+		out.write((uint64_t)used);
+		out.write(generation);
+	}
+	void load(SnapshotReader& in) {
+		in.read(slots);
+		uint64_t readUsed = 0;
+		in.read(readUsed);
+		used = (size_t)readUsed;
+		in.read(generation);
+		// The table's size must stay a power of 2
+		if ((slots.size() & (slots.size() - 1)) != 0) in.fail();
+	}
+private:
+	struct Slot {
+		int tile;
+		int count;
+		uint32_t generation;
+	};
+
+	uint32_t slotOf(int tile) const {
+		uint32_t hash = (uint32_t)tile * 2654435761u;
+		return (hash ^ (hash >> 16)) & (uint32_t)(slots.size() - 1);
+	}
+	void grow() {
+		std::vector<Slot> oldSlots;
+		oldSlots.swap(slots);
+		slots.assign(oldSlots.empty() ? 64 : oldSlots.size() * 2, { 0, 0, 0 });
+
+		// Move over the tiles visited in this generation
+		for (size_t i = 0; i < oldSlots.size(); i++) {
+			if (oldSlots[i].generation != generation) continue;
+
+			uint32_t j = slotOf(oldSlots[i].tile);
+			while (slots[j].generation == generation) j = (j + 1) & (uint32_t)(slots.size() - 1);
+			slots[j] = oldSlots[i];
+		}
+	}
+
+	std::vector<Slot> slots; // Open addressing table whose size is always a power of 2
+	size_t used = 0;		 // Number of tiles visited in this generation
+	uint32_t generation = 1;
+};
+
+// Get weight of an item
+inline int weightOf(int item) {
+	int result = item % MAX_WEIGHT;
+	if (result == 0) result = MAX_WEIGHT;
+	return result;
+}
+
+// Items that still have to be retrieved, and the known shelves holding the items no robot has taken yet
+class OrderIndex {
+public:
+	// Starts with no orders for items 1 to numberOfItems and no known shelves on a map of width by height tiles
+	void reset(int numberOfItems, int width, int height) {
+		orders.assign(numberOfItems + 1, 0);
+		pending.assign(numberOfItems + 1, 0);
+		pendingPosition.assign(numberOfItems + 1, -1);
+		pendingItems.clear();
+		shelves.assign(numberOfItems + 1, std::vector<int>());
+		pendingShelves.reset(width, height, width * height);
+		for (int i = 0; i <= MAX_WEIGHT; i++) pendingByWeight[i] = 0;
+		retrieved = 0;
+	}
+
+	// Order one more of an item
+	void addOrder(int item) {
+		orders[item]++;
+		changePending(item, 1);
+	}
+	// An item is being taken off a shelf; returns false if no order is waiting for it
+	bool reserve(int item) {
+		if (!isItem(item) || pending[item] == 0) return false;
+
+		changePending(item, -1);
+		return true;
+	}
+	// A shelf holding an item has been discovered; x and y are the tile the item is taken from
+	void addShelf(int item, int tile, int x, int y) {
+		if (!isItem(item)) return;
+
+		shelves[item].push_back(tile);
+		if (pending[item] > 0) pendingShelves.insert(tile, x, y);
+	}
+	// An item is being handed in; returns false if there is no order for it
+	bool submit(int item) {
+		if (!isItem(item) || orders[item] == 0) return false;
+
+		orders[item]--;
+		retrieved++;
+		return true;
+	}
+	// Get functions
+	int getRetrieved() {
+		return retrieved;
+	}
+	// Items with orders that no robot has taken off a shelf yet
+	const std::vector<int>& getPendingItems() {
+		return pendingItems;
+	}
+	// Known shelves holding items with orders that no robot has taken yet, by the tile the item is taken from
+	const PointIndex& getPendingShelves() {
+		return pendingShelves;
+	}
+	// Weight of the lightest item with orders that no robot has taken yet; MAX_WEIGHT if none are lighter
+	int getLightestPending() {
+		for (int i = 1; i < MAX_WEIGHT; i++) {
+			if (pendingByWeight[i] > 0) return i;
+		}
+		return MAX_WEIGHT;
+	}
+	void save(SnapshotWriter& out) const {
+		out.write(orders);
+		out.write(pending);
+		out.write(pendingPosition);
+		out.write(pendingItems);
+		out.write(shelves);
+		pendingShelves.save(out);
+		out.write(pendingByWeight);
+		out.write(retrieved);
+	}
+	void load(SnapshotReader& in) {
+		in.read(orders);
+		in.read(pending);
+		in.read(pendingPosition);
+		in.read(pendingItems);
+		in.read(shelves);
+		pendingShelves.load(in);
+		in.read(pendingByWeight);
+		in.read(retrieved);
+	}
+	// Write only the orders not handed in yet and the number retrieved, or read them back with no items pending
+	// This is all that taking and handing in items needs when replaying a trace, as the robots' decisions are not made again
+	void saveOrders(SnapshotWriter& out) const {
+		out.write(orders);
+		out.write(retrieved);
+	}
+	void loadOrders(SnapshotReader& in) {
+		in.read(orders);
+		in.read(retrieved);
+		pending.assign(orders.size(), 0);
+		pendingPosition.assign(orders.size(), -1);
+		pendingItems.clear();
+		shelves.assign(orders.size(), std::vector<int>());
+		for (int i = 0; i <= MAX_WEIGHT; i++) pendingByWeight[i] = 0;
+	}
+private:
+	bool isItem(int item) {
+		return item > 0 && item < (int)orders.size();
+	}
+	void changePending(int item, int change) {
+		// Add to the list of pending items
+		if (pending[item] == 0) {
+			pendingPosition[item] = (int)pendingItems.size();
+			pendingItems.push_back(item);
+			for (int i = 0; i < (int)shelves[item].size(); i++) {
+				pendingShelves.insert(shelves[item][i], pendingShelves.getX(shelves[item][i]), pendingShelves.getY(shelves[item][i]));
+			}
+		}
+
+		pending[item] += change;
+		pendingByWeight[weightOf(item)] += change;
+
+		// Swap the last pending item into this item's place
+		if (pending[item] == 0) {
+			int last = pendingItems.back();
+			pendingItems[pendingPosition[item]] = last;
+			pendingPosition[last] = pendingPosition[item];
+			pendingItems.pop_back();
+			pendingPosition[item] = -1;
+			for (int i = 0; i < (int)shelves[item].size(); i++) {
+				pendingShelves.remove(shelves[item][i]);
+			}
+		}
+	}
+
+	std::vector<int> orders;		  // Number of orders not handed in yet for each item
+	std::vector<int> pending;		  // Number of orders for each item that no robot has taken off a shelf yet
+	std::vector<int> pendingPosition; // Index of each item in pendingItems; -1 if not pending
+	std::vector<int> pendingItems;
+	std::vector<std::vector<int>> shelves; // Known shelf tiles holding each item
+	PointIndex pendingShelves;			   // Known shelves holding pending items
+	int pendingByWeight[MAX_WEIGHT + 1] = { 0 };
+	int retrieved = 0;
+};
+
+// Robot class
+class Robot {
+public:
+	Robot(float x, float y, int setTile, int direction = 1, float setBattery = 100, int setItems[MAX_WEIGHT] = nullptr) {
+		hitbox = { x, y, WH, WH };
+		tile = setTile;
+		battery = setBattery;
+		sprite = 3;
+		dir = direction;
+		weight = 0;
+		if (setItems == nullptr) {
+			for (int i = 0; i < MAX_WEIGHT; i++) {
+				items[i] = 0;
+			}
+		}
+		else {
+			for (int i = 0; i < MAX_WEIGHT; i++) {
+				items[i] = setItems[i];
+				if (setItems[i] != 0) weight += weightOf(setItems[i]);
+			}
+		}
+	}
+
+	// Get functions
+	Box getBox() {
+		return hitbox;
+	}
+	int getTile() {
+		return tile;
+	}
+	int getItem(int index) {
+		return items[index];
+	}
+	int* getItems() {
+		return items;
+	}
+	int getWeight() {
+		return weight;
+	}
+	float getBattery() {
+		return battery;
+	}
+	int getDir() {
+		return dir;
+	}
+	int getSprite() {
+		return sprite;
+	}
+	int getHistory(const SimSettings& settings, int index) {
+		if (index >= 0 && index <= settings.mapWidth * settings.mapHeight / WH / WH) return visitHistory.get(index);
+		else return 0;
+	}
+
+	void addItem(int item) {
+		// Add this item to the robot
+		if (item != 0) {
+			for (int i = 0; i < MAX_WEIGHT; i++) {
+				if (items[i] == 0) {
+					items[i] = item;
+					weight += weightOf(item);
+					break;
+				}
+			}
+		}
+	}
+	void clearItems() {
+		for (int i = 0; i < MAX_WEIGHT; i++) items[i] = 0;
+		
+		weight = 0;
+	}
+
+	// Set functions
+	void setXY(float x, float y, int setTile) {
+		hitbox.x = x;
+		hitbox.y = y;
+		tile = setTile;
+	}
+	void setDir(int direction) {
+		dir = direction;
+	}
+	void setBattery(float batteryLevel) {
+		battery = batteryLevel;
+
+		if (battery < 0) battery = 0;
+
+		// Set sprite based on battery
+		if (battery == 0) sprite = 0;
+		else if (battery < 20) sprite = 1;
+		else if (battery < 50) sprite = 2;
+	}
+
+	// Actions
+	bool turn(int direction) {
+		if (battery > 0 && dir != direction) {
+			dir = direction;
+
+			// Decrement battery
+			battery -= BATTERY_LOSS;
+			if (battery < 0) battery = 0;
+
+			// Set sprite based on battery
+			if (battery == 0) sprite = 0;
+			else if (battery < 20) sprite = 1;
+			else if (battery < 50) sprite = 2;
+
+			return true;
+		}
+		else return false;
+	}
+	bool move(const SimSettings& settings, const TileGrid& tiles, RobotGrid& robotGrid) {
+		bool success = true;
+
+		if (battery > 0 && weight <= MAX_WEIGHT) {
+			// Move robot
+			switch (dir) {
+			case 0: hitbox.y -= WH; break;
+			case 1: hitbox.y += WH; break;
+			case 2: hitbox.x -= WH; break;
+			case 3: hitbox.x += WH; break;
+			}
+
+			// Set flag to cancel robot movement if it would collide with something
+			int newTile = tile;
+			if (hitbox.x < 0 || hitbox.x > settings.mapWidth - WH) success = false;
+			else if (hitbox.y < 0 || hitbox.y > settings.mapHeight - WH) success = false;
+			else {
+				newTile = tileIndex(settings, hitbox.x, hitbox.y);
+
+				// Check that the new tile is walkable
+				if (tiles.contains(newTile)) {
+					if (tiles.getType(newTile) != 1 && (tiles.getType(newTile) < 6 || tiles.getType(newTile) > 8)) success = false;
+				}
+
+				// Check that there is no other robot on the new tile
+				if (success && robotGrid.robotAt(newTile) >= 0) success = false;
+			}
+
+			// Cancel robot movement
+			if (!success) {
+				switch (dir) {
+				case 0: hitbox.y += WH; break;
+				case 1: hitbox.y -= WH; break;
+				case 2: hitbox.x += WH; break;
+				case 3: hitbox.x -= WH; break;
+				}
+			}
+			// Update tile and decrement battery
+			else {
+				robotGrid.moveRobot(tile, newTile);
+				tile = newTile;
+
+				battery -= BATTERY_LOSS;
+				if (battery < 0) battery = 0;
+
+				// Set sprite based on battery
+				if (battery == 0) sprite = 0;
+				else if (battery < 20) sprite = 1;
+				else if (battery < 50) sprite = 2;
+			}
+		}
+		else success = false;
+
+		// Returns true if moved successfully
+		return success;
+	}
+	bool takeShelfItem(const SimSettings& settings, const TileGrid& tiles, OrderIndex& orders) {
+		int currentTile = getTile();
+		int map_width = settings.mapWidth / WH;
+		int map_height = settings.mapHeight / WH;
+
+		switch (dir) {
+		case 0: // Up
+			// Check within bounds
+			if (currentTile - map_width > 0 && tiles.contains(currentTile - map_width)) {
+				if (tiles.contains(currentTile - map_width)) {
+					// Check that the tile above is a bottom-facing shelf
+					if (tiles.getType(currentTile - map_width) == 3) {
+						// Check that the robot can still hold this item
+						if (weight + tiles.getWeight(currentTile - map_width) > MAX_WEIGHT) return false;
+
+						// Remove this item from the items still waiting to be taken
+						orders.reserve(tiles.getItem(currentTile - map_width));
+
+						// Take an item
+						addItem(tiles.getItem(currentTile - map_width));
+					}
+					else return false;
+				}
+				else return false;
+			}
+			break;
+		case 1: // Down
+			// Check within bounds
+			if (currentTile + map_width < map_width * map_height && tiles.contains(currentTile + map_width)) {
+				if (tiles.contains(currentTile + map_width)) {
+					// Check that the tile below is a top-facing shelf
+					if (tiles.getType(currentTile + map_width) == 2) {
+						// Check that the robot can still hold this item
+						if (weight + tiles.getWeight(currentTile + map_width) > MAX_WEIGHT) return false;
+
+						// Remove this item from the items still waiting to be taken
+						orders.reserve(tiles.getItem(currentTile + map_width));
+
+						// Take an item
+						addItem(tiles.getItem(currentTile + map_width));
+					}
+					else return false;
+				}
+				else return false;
+			}
+			break;
+		case 2: // Left
+			// Check within bounds
+			if (currentTile % map_width > 0 && tiles.contains(currentTile - 1)) {
+				if (tiles.contains(currentTile - 1)) {
+					// Check that the tile to the left is a right-facing shelf
+					if (tiles.getType(currentTile - 1) == 5) {
+						// Check that the robot can still hold this item
+						if (weight + tiles.getWeight(currentTile - 1) > MAX_WEIGHT) return false;
+
+						// Remove this item from the items still waiting to be taken
+						orders.reserve(tiles.getItem(currentTile - 1));
+
+						// Take an item
+						addItem(tiles.getItem(currentTile - 1));
+					}
+					else return false;
+				}
+				else return false;
+			}
+			break;
+		case 3: // Right
+			// Check within bounds
+			if (currentTile % map_width < map_width - 1 && tiles.contains(currentTile + 1)) {
+				if (tiles.contains(currentTile + 1)) {
+					// Check that the tile to the right is a left-facing shelf
+					if (tiles.getType(currentTile + 1) == 4) {
+						// Check that the robot can still hold this item
+						if (weight + tiles.getWeight(currentTile + 1) > MAX_WEIGHT) return false;
+
+						// Remove this item from the items still waiting to be taken
+						orders.reserve(tiles.getItem(currentTile + 1));
+
+						// Take an item
+						addItem(tiles.getItem(currentTile + 1));
+					}
+					else return false;
+				}
+				else return false;
+			}
+			break;
+		}
+
+		battery -= BATTERY_LOSS;
+		if (battery < 0) battery = 0;
+
+		// Set sprite based on battery
+		if (battery == 0) sprite = 0;
+		else if (battery < 20) sprite = 1;
+		else if (battery < 50) sprite = 2;
+
+		return true;
+	}
+	bool takeRobotItem(const SimSettings& settings, Robot* robots[], RobotGrid& robotGrid) {
+		bool success = false;
+
+		// Check that there is a robot in front
+		int other = robotGrid.robotAt(neighbourTile(settings, getTile(), dir));
+		if (other >= 0 && robots[other] != nullptr) {
+			// If we have nothing on hand
+			if (weight == 0) {
+				// Add all of the dead robot's items to our hand
+				for (int j = 0; j < MAX_WEIGHT; j++) addItem(robots[other]->getItem(j));
+
+				// Clear the dead robot's hand
+				robots[other]->clearItems();
+				success = true;
+			}
+		}
+
+		if (success) {
+			// Decrement battery
+			battery -= BATTERY_LOSS;
+			if (battery < 0) battery = 0;
+
+			// Set sprite based on battery
+			if (battery == 0) sprite = 0;
+			else if (battery < 20) sprite = 1;
+			else if (battery < 50) sprite = 2;
+		}
+		
+		return success;
+	}
+	bool charge(const TileGrid& tiles) {
+		// If standing on a charger tile, increase battery level
+		if (tiles.contains(getTile())) {
+			if (tiles.getType(getTile()) == 6) {
+				battery += BATTERY_GAIN;
+				if (battery > 100) battery = 100;
+
+				// Set sprite based on battery
+				if (battery == 0) sprite = 0;
+				else if (battery < 20) sprite = 1;
+				else if (battery < 50) sprite = 2;
+				else sprite = 3;
+
+				return true;
+			}
+		}
+		return false;
+	}
+	bool passItem(const SimSettings& settings, Robot* robots[], RobotGrid& robotGrid, const TileGrid& tiles, int item) {
+		int currentTile = getTile();
+		int map_width = settings.mapWidth / WH;
+		int map_height = settings.mapHeight / WH;
+		int other = -1;
+
+		switch (dir) {
+		case 0: // Up
+			// Check within bounds
+			if (currentTile - map_width > 0 && tiles.contains(currentTile - map_width)) {
+				// Check that there is a robot above
+				other = robotGrid.robotAt(currentTile - map_width);
+				if (other >= 0 && robots[other] != nullptr) {
+					// If that robot has room for the item
+					if (robots[other]->getWeight() <= MAX_WEIGHT - weightOf(item)) {
+						// Remove item from this robot
+						for (int j = 0; j < MAX_WEIGHT; j++) {
+							if (items[j] == item) {
+								items[j] = 0;
+								weight -= weightOf(item);
+								break;
+							}
+						}
+
+						// Pass the item to that robot
+						robots[other]->addItem(item);
+
+						battery -= BATTERY_LOSS;
+						if (battery < 0) battery = 0;
+
+						// Set sprite based on battery
+						if (battery == 0) sprite = 0;
+						else if (battery < 20) sprite = 1;
+						else if (battery < 50) sprite = 2;
+
+						return true;
+					}
+				}
+			}
+			break;
+		case 1: // Down
+			// Check within bounds
+			if (currentTile + map_width < map_width * map_height && tiles.contains(currentTile + map_width)) {
+				// Check that there is a robot below
+				other = robotGrid.robotAt(currentTile + map_width);
+				if (other >= 0 && robots[other] != nullptr) {
+					// If that robot has room for the item
+					if (robots[other]->getWeight() <= MAX_WEIGHT - item) {
+						// Remove item from this robot
+						for (int j = 0; j < MAX_WEIGHT; j++) {
+							if (items[j] == item) {
+								items[j] = 0;
+								weight -= item;
+								break;
+							}
+						}
+
+						// Pass the item to that robot
+						robots[other]->addItem(item);
+
+						battery -= BATTERY_LOSS;
+						if (battery < 0) battery = 0;
+
+						// Set sprite based on battery
+						if (battery == 0) sprite = 0;
+						else if (battery < 20) sprite = 1;
+						else if (battery < 50) sprite = 2;
+
+						return true;
+					}
+				}
+			}
+			break;
+		case 2: // Left
+			if (currentTile % map_width > 0 && tiles.contains(currentTile - 1)) {
+				// Check that there is a robot to the left
+				other = robotGrid.robotAt(currentTile - 1);
+				if (other >= 0 && robots[other] != nullptr) {
+					// If that robot has room for the item
+					if (robots[other]->getWeight() <= MAX_WEIGHT - item) {
+						// Remove item from this robot
+						for (int j = 0; j < MAX_WEIGHT; j++) {
+							if (items[j] == item) {
+								items[j] = 0;
+								weight -= item;
+								break;
+							}
+						}
+
+						// Pass the item to that robot
+						robots[other]->addItem(item);
+
+						battery -= BATTERY_LOSS;
+						if (battery < 0) battery = 0;
+
+						// Set sprite based on battery
+						if (battery == 0) sprite = 0;
+						else if (battery < 20) sprite = 1;
+						else if (battery < 50) sprite = 2;
+
+						return true;
+					}
+				}
+			}
+			break;
+		case 3: // Right
+			if (currentTile % map_width < map_width - 1 && tiles.contains(currentTile + 1)) {
+				// Check that there is a robot to the right
+				other = robotGrid.robotAt(currentTile + 1);
+				if (other >= 0 && robots[other] != nullptr) {
+					// If that robot has room for the item
+					if (robots[other]->getWeight() <= MAX_WEIGHT - item) {
+						// Remove item from this robot
+						for (int j = 0; j < MAX_WEIGHT; j++) {
+							if (items[j] == item) {
+								items[j] = 0;
+								weight -= item;
+								break;
+							}
+						}
+
+						// Pass the item to that robot
+						robots[other]->addItem(item);
+
+						battery -= BATTERY_LOSS;
+						if (battery < 0) battery = 0;
+
+						// Set sprite based on battery
+						if (battery == 0) sprite = 0;
+						else if (battery < 20) sprite = 1;
+						else if (battery < 50) sprite = 2;
+
+						return true;
+					}
+				}
+			}
+			break;
+		}
+
+		return false;
+	}
+	bool submitItems(const TileGrid& tiles, OrderIndex& orders) {
+		bool success = false;
+		// If standing on a submission tile
+		if (tiles.contains(getTile())) {
+			if (tiles.getType(getTile()) == 8) {
+				for (int j = 0; j < MAX_WEIGHT; j++) {
+					// Submit the item if it was ordered
+					if (items[j] != 0 && orders.submit(items[j])) {
+						weight -= weightOf(items[j]);
+						items[j] = 0;
+
+						success = true;
+					}
+				}
+			}
+		}
+		if (success) {
+			// Decrement battery
+			battery -= BATTERY_LOSS;
+			if (battery < 0) battery = 0;
+
+			// Set sprite based on battery
+			if (battery == 0) sprite = 0;
+			else if (battery < 20) sprite = 1;
+			else if (battery < 50) sprite = 2;
+		}
+
+		return success;
+	}
+
+	// Records the tiles next to and ahead of the robot in tileDatabase; returns the number of tiles looked at
+	int sight(const SimSettings& settings, const TileGrid& tiles, TileGrid& tileDatabase, std::vector<int>& changedTiles) {
+		int currentTile = getTile();
+		int sightRange = 10 + 1;
+		int map_width = settings.mapWidth / WH;
+		int map_height = settings.mapHeight / WH;
+		int tilesScanned = 0;
+
+		// Record tiles around the robot
+		// Up
+		if (currentTile - map_width >= 0) {
+			if (tiles.contains(currentTile - map_width)) {
+				tilesScanned++;
+				if (tileDatabase.record(tiles, currentTile - map_width)) changedTiles.push_back(currentTile - map_width);
+			}
+		}
+		// Down
+		if (currentTile + map_width < map_width * map_height) {
+			if (tiles.contains(currentTile + map_width)) {
+				tilesScanned++;
+				if (tileDatabase.record(tiles, currentTile + map_width)) changedTiles.push_back(currentTile + map_width);
+			}
+		}
+		// Left
+		if (currentTile % map_width != 0) {
+			if (tiles.contains(currentTile - 1)) {
+				tilesScanned++;
+				if (tileDatabase.record(tiles, currentTile - 1)) changedTiles.push_back(currentTile - 1);
+			}
+		}
+		// Right
+		if (currentTile % map_width != map_width - 1) {
+			if (tiles.contains(currentTile + 1)) {
+				tilesScanned++;
+				if (tileDatabase.record(tiles, currentTile + 1)) changedTiles.push_back(currentTile + 1);
+			}
+		}
+
+		// Record tiles up to 10 tiles ahead of the robot
+		bool stop = false;
+		for (int i = 0; i < sightRange && !stop; i++) {
+			if (tiles.contains(currentTile)) {
+				// Record tile in database
+				if (tileDatabase.contains(currentTile)) {
+					tilesScanned++;
+					if (tileDatabase.record(tiles, currentTile)) changedTiles.push_back(currentTile);
+				}
+
+				// Stop sight if this tile is a shelf or wall or obstacle
+				if ((tiles.getType(currentTile) >= 2 && tiles.getType(currentTile) <= 5) || tiles.getType(currentTile) == 0 || tiles.getType(currentTile) == 9) break;
+
+				// Stop sight if next tile is out of bounds
+				switch (dir) {
+				case 0: // Up
+					if (currentTile - map_width < 0) stop = true;
+					else if (!tiles.contains(currentTile - map_width)) stop = true;
+
+					// Go to next tile
+					else currentTile -= map_width;
+
+					break;
+				case 1: // Down
+					if (currentTile + map_width >= map_width * map_height) stop = true;
+					else if (!tiles.contains(currentTile + map_width)) stop = true;
+
+					// Go to next tile
+					else currentTile += map_width;
+
+					break;
+				case 2: // Left
+					if (currentTile % map_width == 0) stop = true;
+					else if (!tiles.contains(currentTile - 1)) stop = true;
+
+					// Go to next tile
+					else currentTile--;
+
+					break;
+				case 3: // Right
+					if (currentTile % map_width == map_width - 1) stop = true;
+					else if (!tiles.contains(currentTile + 1)) stop = true;
+
+					// Go to next tile
+					else currentTile++;
+
+					break;
+				}
+			}
+		}
+		return tilesScanned;
+	}
+	void updateHistory(const TileGrid& tiles) {
+		int currentTile = getTile();
+
+		if (tiles.contains(currentTile)) visitHistory.add(currentTile);
+	}
+	void resetHistory() {
+		visitHistory.reset();
+	}
+	// Write the robot into a snapshot, or read it back
+	void save(SnapshotWriter& out) const {
+		out.write(hitbox);
+		out.write(tile);
+		out.write(battery);
+		out.write(sprite);
+		out.write(dir);
+		out.write(items);
+		out.write(weight);
+		visitHistory.save(out);
+	}
+	void load(SnapshotReader& in) {
+		in.read(hitbox);
+		in.read(tile);
+		in.read(battery);
+		in.read(sprite);
+		in.read(dir);
+		in.read(items);
+		in.read(weight);
+		visitHistory.load(in);
+	}
+private:
+	Box hitbox;
+	int tile; // Index of the tile the robot is on
+	float battery;
+	int sprite;
+	int dir; // 0: up, 1: down, 2: left, 3: right
+	int items[MAX_WEIGHT]; // the items being held by the robot
+	int weight; // the current weight of items that the robot is carrying
+	VisitHistory visitHistory; // How many times it has visited each tile
+};
+
+// Width and height in tiles of a numbered map, read from its map file; returns false if the file could not be read
+bool mapSizeOf(int mapNumber, int& width, int& height);
+// Path of a numbered map file
+std::string mapPathOf(int mapNumber);
+
+// Write settings into a snapshot or trace, or read them back
+void writeSettings(SnapshotWriter& out, const SimSettings& settings);
+void readSettings(SnapshotReader& in, SimSettings& settings);
+
+// A combination of settings used when testing
+struct TestSetting {
+	int mapNumber;
+	int robots;
+	int obstacles;
+};
+
+// The 24 predefined, logical combinations of settings ("Test")
+std::vector<TestSetting> logicalTestSettings();
+// All 1568 combinations of settings ("Test All")
+std::vector<TestSetting> allTestSettings();
+
+// What a robot decided to do this tick
+struct RobotDecision {
+	bool alive = false;
+	bool waitingForCharger = false;
+	bool submit = false;
+	bool chargeBattery = false;
+	bool takeRobotItems = false;
+	bool takeItemFromShelf = false;
+	bool passItemAway = false;
+	int takeDir = -1;
+	int passDir = 0;
+	int itemToPass = 0;
+	int recipientRobot = 0;
+	int bestAction = 0;
+	int rescuer = -1; // Robot to rescue a dead robot; -1 to leave its rescuer unchanged
+};
+
+// Threads that decide robot actions in two-phase ticks
+class TickWorkers;
+
+// Headless simulation engine, free of any rendering or input handling
+class WarehouseSim {
+public:
+	WarehouseSim(const SimSettings& simSettings, uint64_t seed);
+	~WarehouseSim();
+
+	// Converts the map file into tiles and takes the size of the map from it; prints an error and returns false if the map could not be loaded
+	bool loadMap();
+	// Creates robots in random valid locations
+	void spawnRobots();
+	// Creates the list of items to retrieve
+	void createItemList();
+
+	// Runs one tick of the simulation; returns false once the simulation has finished
+	bool step();
+	// Fail the simulation on the next tick
+	void skip() {
+		skipRequested = true;
+	}
+
+	// Snapshots hold the whole state of a simulation between ticks, including its random number generator but not its tick timings
+	std::vector<uint8_t> takeSnapshot() const;
+	// Returns false if the file could not be written
+	bool saveSnapshot(const std::string& path) const;
+	// A simulation that carries on exactly as the one the snapshot was taken of; nullptr if the snapshot is not valid
+	static std::unique_ptr<WarehouseSim> fromSnapshot(const std::vector<uint8_t>& snapshot);
+	static std::unique_ptr<WarehouseSim> loadSnapshot(const std::string& path);
+	// Copy of the simulation that carries on from its current state with random numbers from its own seed, to compare several variants from one warmed-up state
+	// The obstacles, tick limit, two-phase ticks, tick threads, profiling and throughput recording of variant are used; the map, robots and items stay the same
+	// nullptr if the snapshot of its state could not be restored
+	std::unique_ptr<WarehouseSim> fork(const SimSettings& variant, uint64_t variantSeed) const;
+	const SimSettings& getSettings() {
+		return settings;
+	}
+	uint64_t getSeed() {
+		return seed;
+	}
+
+	// Metrics
+	int getTicks() {
+		return ticks;
+	}
+	int getItemsRetrieved() {
+		return orders.getRetrieved();
+	}
+	int getNumDeadRobots() {
+		return numDeadRobots;
+	}
+	bool isFinished() {
+		return finished;
+	}
+	bool isCompleted() {
+		return completed;
+	}
+	bool isFailed() {
+		return failed;
+	}
+	// Why the simulation failed ("dead robots", "skipped" or "tick limit"); empty unless it failed
+	const std::string& getFailureReason() {
+		return failureReason;
+	}
+	// Items retrieved in every THROUGHPUT_TICKS ticks, and in the ticks after the last full interval once finished; empty unless recorded
+	const std::vector<int>& getThroughput() {
+		return throughput;
+	}
+
+	// State for rendering
+	const TileGrid& getTiles() {
+		return tiles;
+	}
+	const TileGrid& getKnownTiles() {
+		return tileDatabase;
+	}
+	// The robot with an index; nullptr if there is none
+	Robot* getRobot(int index) {
+		if (index >= 0 && index < (int)robots.size()) return robots[index];
+		else return nullptr;
+	}
+	int getNumberOfRobots() {
+		return (int)robots.size();
+	}
+	// Timings of the ticks so far; only recorded if profiling is enabled in the settings
+	TickProfiler& getProfiler() {
+		return profiler;
+	}
+	// Events of the ticks so far, from the state at the first tick; only recorded if enabled in the settings
+	const EventTrace& getTrace() {
+		return trace;
+	}
+private:
+	// Start the trace with the state the simulation is in now
+	void startTrace();
+	// Does the work of loadMap(); returns false if the map could not be loaded
+	bool readMap();
+	void generateObstacles();
+	// Run the two phases of a tick, deciding all robots' actions before carrying any out
+	void stepTwoPhase();
+	void processRobot(int i);
+	// Decide a robot's action from the current state, only writing the robot's own state
+	void decideRobot(int i, RobotDecision& decision);
+	// Carry out a robot's decided action, skipping moves and passes that are no longer possible
+	void actRobot(int i, const RobotDecision& decision);
+	// Set the robot to rescue a dead robot
+	void setRescuer(int deadRobotIndex, int rescuer);
+	// Add or remove a robot from the robots that can rescue dead robots
+	void updateIdle(int robot);
+	// Recalculate the paths to free chargers or exits if the known map changed
+	void updateChargerField();
+	void updateExitField();
+	void updateFrontierField();
+	// Check if a tile is unknown and next to a known walkable tile
+	bool isFrontier(int tile);
+	// Check if robot j is closer to robot i's goal than robot i is
+	bool closerToGoal(int j, int i, DistanceField* goalField, float goalX, float goalY);
+	// Tile a robot takes a shelf's item from, and the direction it faces to do so
+	void shelfAccessOf(int shelf, int& x, int& y, int& facing);
+
+	SimSettings settings;
+	uint64_t seed;
+	SimRandom random;
+
+	TileGrid tiles;
+	TileGrid tileDatabase; // The tiles known to the robots
+	std::vector<Robot*> robots;
+	RobotGrid robotGrid;
+	TileSampler spawnTiles; // Walkable tiles with no robot, before robots are spawned
+	TileSampler freeFloor;	// Floor tiles with no robot or obstacle on them
+	std::vector<int> obstacles; // Obstacle tiles, turned back into floor before new ones are placed
+	PointIndex idleRobots; // Robots with enough battery and no items, which can rescue dead robots, by their tile
+	int numberOfShelves = 0;
+
+	OrderIndex orders;
+	std::vector<int> changedTiles; // Known tiles changed by a robot's sight this tick
+	DistanceField chargerField; // Paths to known chargers that no robot is standing on
+	DistanceField exitField;	// Paths to known exits
+	DistanceField frontierField; // Paths to the unknown tiles next to known walkable tiles
+	PointIndex unknownTiles;	 // Tiles not known to the robots yet
+	std::vector<int> goals;		// Goal tiles of the field being recalculated
+	std::vector<uint8_t> receivingItem; // Bytes rather than bits, so robots can clear their own flag in parallel
+	bool chargerKnown = false;
+	std::vector<int> deadRobot; // index is the dead robot, value is the robot to rescue it
+	std::vector<std::set<int>> robotsToRescue; // The robots whose deadRobot value is each robot, so the first can be found without checking every robot
+	std::vector<float> currentGoal; // 0: explore, 1: shelf, 2: charger, 3: exit, 4: dead robot
+	std::vector<RobotDecision> decisions; // Decisions of the robots in a two-phase tick
+	std::vector<int> actOrder;			  // Order in which robots act in a two-phase tick
+	std::unique_ptr<TickWorkers> workers;
+	TickProfiler profiler;
+	EventTrace trace;
+
+	int ticks = 0;
+	int numDeadRobots = 0;
+	bool skipRequested = false;
+	bool finished = false;
+	bool completed = false;
+	bool failed = false;
+	std::string failureReason;
+	std::vector<int> throughput;
+	int throughputRetrieved = 0; // Items retrieved up to the last point of the throughput series
+};